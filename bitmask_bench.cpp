@@ -0,0 +1,154 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "line_bits.h"
+
+// Change detection cost: gpiod_line_value arrays compared line by line
+// (as input_simple does) against packed words compared with XOR and
+// count-trailing-zeros (line_bits.h, as input_bitmask does).
+//
+// For each line count, a sequence of samples is generated in which a few
+// random lines change from one sample to the next (the usual case: most
+// lines are quiet most of the time). Both methods walk the same sequence
+// and count the changes they find; the counts must agree. Only detection
+// is timed, not reading the lines.
+//
+// Usage: bitmask_bench [changes_per_sample]    (default 1)
+
+static const int line_counts[] = { 2, 8, 16, 32, 64, 128, 256, 512, 1024, 4096 };
+static const int num_samples = 1024;    // walked in order on each pass
+static const uint64_t min_run_ns = 200000000;
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+// Each detect_ function walks all samples 'passes' times, returns the
+// time taken, and gives back the number of changes found and the sum of
+// the changed line numbers (to check the two agree, and so the compiler
+// can't drop the work).
+
+// Per-line compare, as input_simple does.
+static uint64_t detect_array(gpiod_line_value *const *samples, int num_lines, int passes,
+                             uint64_t &changed_count, uint64_t &changed_sum)
+{
+    uint64_t start_ns = now_ns();
+    uint64_t changes = 0, sum = 0;
+    for (int p = 0; p < passes; p++) {
+        for (int s = 1; s < num_samples; s++) {
+            const gpiod_line_value *old_values = samples[s - 1];
+            const gpiod_line_value *new_values = samples[s];
+            for (int i = 0; i < num_lines; i++) {
+                if (old_values[i] != new_values[i]) {
+                    changes++;
+                    sum += i; // stand-in for doing something with the change
+                }
+            }
+        }
+    }
+    uint64_t elapsed_ns = now_ns() - start_ns;
+    changed_count = changes;
+    changed_sum = sum;
+    return elapsed_ns;
+}
+
+
+static uint64_t detect_bits(uint64_t *const *samples, int num_words, int passes,
+                            uint64_t &changed_count, uint64_t &changed_sum)
+{
+    uint64_t start_ns = now_ns();
+    uint64_t changes = 0, sum = 0;
+    for (int p = 0; p < passes; p++) {
+        for (int s = 1; s < num_samples; s++) {
+            changes += line_bits_changes(samples[s - 1], samples[s], num_words,
+                                         [&](int line, int value) { sum += line; });
+        }
+    }
+    uint64_t elapsed_ns = now_ns() - start_ns;
+    changed_count = changes;
+    changed_sum = sum;
+    return elapsed_ns;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    int changes_per_sample = argc > 1 ? atoi(argv[1]) : 1;
+    if (argc > 2 || changes_per_sample < 0) {
+        fprintf(stderr, "usage: %s [changes_per_sample]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d changes per sample; nsec per sample\n", changes_per_sample);
+    printf("%6s %10s %10s %8s\n", "lines", "array", "bits", "speedup");
+
+    srandom(1);
+
+    for (int num_lines : line_counts) {
+
+        int num_words = line_bits_words(num_lines);
+
+        // Build the samples both ways.
+        gpiod_line_value **array_samples = new gpiod_line_value *[num_samples];
+        uint64_t **bit_samples = new uint64_t *[num_samples];
+        for (int s = 0; s < num_samples; s++) {
+            array_samples[s] = new gpiod_line_value[num_lines];
+            bit_samples[s] = new uint64_t[num_words];
+            if (s == 0) {
+                memset(bit_samples[s], 0, num_words * sizeof(uint64_t));
+                for (int i = 0; i < num_lines; i++) {
+                    int v = random() & 1;
+                    array_samples[s][i] = v ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE;
+                    line_bits_set(bit_samples[s], i, v);
+                }
+            } else {
+                memcpy(array_samples[s], array_samples[s - 1],
+                       num_lines * sizeof(gpiod_line_value));
+                memcpy(bit_samples[s], bit_samples[s - 1], num_words * sizeof(uint64_t));
+                for (int c = 0; c < changes_per_sample; c++) {
+                    int i = random() % num_lines;
+                    int v = 1 - line_bits_get(bit_samples[s], i);
+                    array_samples[s][i] = v ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE;
+                    line_bits_set(bit_samples[s], i, v);
+                }
+            }
+        }
+
+        // Time enough passes for a stable number.
+        uint64_t array_changes, array_sum, bits_changes, bits_sum;
+        int passes = 1;
+        uint64_t array_ns;
+        while ((array_ns = detect_array(array_samples, num_lines, passes,
+                                        array_changes, array_sum)) < min_run_ns)
+            passes *= 2;
+        uint64_t bits_ns = detect_bits(bit_samples, num_words, passes, bits_changes, bits_sum);
+
+        // Both must find the same changes.
+        if (array_changes != bits_changes || array_sum != bits_sum) {
+            fprintf(stderr, "mismatch at %d lines\n", num_lines);
+            return 1;
+        }
+
+        double n = double(passes) * (num_samples - 1);
+        printf("%6d %10.1f %10.1f %7.1fx\n", num_lines, array_ns / n, bits_ns / n,
+               double(array_ns) / bits_ns);
+
+        for (int s = 0; s < num_samples; s++) {
+            delete[] array_samples[s];
+            delete[] bit_samples[s];
+        }
+        delete[] array_samples;
+        delete[] bit_samples;
+    }
+
+    return 0;
+
+} // main
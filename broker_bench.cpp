@@ -0,0 +1,201 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <gpiod.h>
+#include "broker_client.h"
+#include "histogram.h"
+
+// Time to first operation, with and without gpio_broker.
+//
+// Direct: open the chip, request the lines as outputs, set them, then
+// release and close (what each example program does at startup).
+// Broker: connect to gpio_broker, get the request fd, set the lines with
+// an ioctl, close the fd.
+//
+// Each is timed from start until the first set returns, over many
+// iterations. The direct lines must not be held by the broker (or anyone
+// else), so with the broker's default set the two halves have to be run
+// separately: -d with the broker stopped, -b with it running. Both in one
+// run works only if the broker holds different lines from -d.
+//
+// Usage: broker_bench [-n iterations] [-d chip:offset[,offset...]]
+//                     [-b name] [-s socket]
+//
+// With neither -d nor -b, runs -b out2 if the broker is answering, and
+// -d /dev/gpiochip0:23,24 (the same lines) if it isn't.
+
+static const int max_lines = 64;
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void print_result(const char *name, const histogram<> &h)
+{
+    printf("%-7s %6" PRIu64 " runs: usec min %.1f p50 %.1f p99 %.1f max %.1f\n", name,
+           h.count(), h.min() / 1e3, h.percentile(50) / 1e3, h.percentile(99) / 1e3,
+           h.max() / 1e3);
+}
+
+
+static bool parse_lines(const char *arg, char *chip_path, size_t chip_len,
+                        unsigned int *offsets, int &num_offsets)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || size_t(colon - arg) >= chip_len)
+        return false;
+    memcpy(chip_path, arg, colon - arg);
+    chip_path[colon - arg] = '\0';
+    num_offsets = 0;
+    const char *p = colon + 1;
+    while (*p != '\0' && num_offsets < max_lines) {
+        char *end;
+        offsets[num_offsets++] = strtoul(p, &end, 0);
+        if (end == p)
+            return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return num_offsets > 0 && *p == '\0';
+}
+
+
+static bool bench_direct(const char *chip_path, const unsigned int *offsets,
+                         int num_offsets, int iterations, histogram<> &h)
+{
+    gpiod_line_value values[max_lines];
+    for (int i = 0; i < num_offsets; i++)
+        values[i] = GPIOD_LINE_VALUE_INACTIVE;
+
+    for (int it = 0; it < iterations; it++) {
+
+        uint64_t start_ns = now_ns();
+
+        gpiod_line_settings *settings = gpiod_line_settings_new();
+        gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+        gpiod_line_config *line_config = gpiod_line_config_new();
+        gpiod_line_config_add_line_settings(line_config, offsets, num_offsets, settings);
+        gpiod_line_settings_free(settings);
+        gpiod_chip *chip = gpiod_chip_open(chip_path);
+        if (chip == nullptr) {
+            gpiod_line_config_free(line_config);
+            return false;
+        }
+        gpiod_line_request *request = gpiod_chip_request_lines(chip, nullptr, line_config);
+        gpiod_line_config_free(line_config);
+        if (request == nullptr) {
+            gpiod_chip_close(chip);
+            return false;
+        }
+        int r = gpiod_line_request_set_values(request, values);
+        assert(r == 0);
+
+        h.record(now_ns() - start_ns);
+
+        gpiod_line_request_release(request);
+        gpiod_chip_close(chip);
+    }
+
+    return true;
+}
+
+
+static bool bench_broker(const char *socket_path, const char *name, int iterations,
+                         histogram<> &h)
+{
+    broker_reply reply;
+
+    for (int it = 0; it < iterations; it++) {
+
+        uint64_t start_ns = now_ns();
+
+        int fd = broker_get_request(socket_path, name, reply);
+        if (fd < 0)
+            return false;
+        uint64_t mask = reply.num_lines >= 64 ? ~uint64_t(0)
+                                              : (uint64_t(1) << reply.num_lines) - 1;
+        int r = broker_set_values(fd, 0, mask);
+        assert(r == 0);
+
+        h.record(now_ns() - start_ns);
+
+        close(fd);
+    }
+
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    int iterations = 1000;
+    const char *direct_arg = nullptr;
+    const char *broker_name = nullptr;
+    const char *socket_path = broker_default_socket;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            direct_arg = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            broker_name = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-n iterations] [-d chip:offset[,offset...]]"
+                    " [-b name] [-s socket]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (direct_arg == nullptr && broker_name == nullptr) {
+        broker_reply reply;
+        int fd = broker_get_request(socket_path, "out2", reply);
+        if (fd >= 0) {
+            close(fd);
+            broker_name = "out2";
+            printf("broker is running: timing it; stop it and run again for direct\n");
+        } else {
+            direct_arg = "/dev/gpiochip0:23,24";
+            printf("broker not running: timing direct; start it and run again for broker\n");
+        }
+    }
+
+    if (direct_arg != nullptr) {
+        char chip_path[64];
+        unsigned int offsets[max_lines];
+        int num_offsets;
+        if (!parse_lines(direct_arg, chip_path, sizeof(chip_path), offsets, num_offsets)) {
+            fprintf(stderr, "bad line spec \"%s\"\n", direct_arg);
+            return 1;
+        }
+        static histogram<> h;
+        if (bench_direct(chip_path, offsets, num_offsets, iterations, h))
+            print_result("direct", h);
+        else
+            printf("direct: can't request lines (held by the broker?): %s\n", strerror(errno));
+    }
+
+    if (broker_name != nullptr) {
+        static histogram<> h;
+        if (bench_broker(socket_path, broker_name, iterations, h))
+            print_result("broker", h);
+        else
+            printf("broker: can't get \"%s\" from %s: %s\n", broker_name, socket_path,
+                   strerror(errno));
+    }
+
+    return 0;
+
+} // main
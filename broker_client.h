@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <errno.h>
+#include <linux/gpio.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Client side of gpio_broker.
+//
+// gpio_broker holds line requests open and hands out their fds over a
+// Unix socket (SCM_RIGHTS). A client gets a working request fd with one
+// connect and one message, instead of opening the chip and requesting
+// the lines itself, and the lines stay requested (outputs keep their
+// values) after the client exits.
+//
+// The client can't make a gpiod_line_request out of a bare fd, so the
+// values are read and written with the kernel's line ioctls directly. Bit
+// i of the values is the i'th line of the request, in the order given by
+// offsets[] in the reply.
+//
+// Protocol: the client sends the name of a line set (no terminator
+// needed, at most broker_max_name bytes) and the broker answers with a
+// broker_reply, carrying the fd if status is 0.
+
+// The broker makes the socket mode 0660, so clients must run as the
+// broker's user or be in its group.
+static const char *const broker_default_socket = "/tmp/gpio_broker.sock";
+static const int broker_max_name = 63;
+static const int broker_max_lines = 64;
+
+struct broker_reply {
+    int32_t status;             // 0 or an errno value
+    uint32_t num_lines;
+    uint32_t offsets[broker_max_lines];
+};
+
+
+// Connect to the broker and get the request fd for line set 'name'.
+// Returns the fd (fills in reply) or -1 with errno set.
+static inline int broker_get_request(const char *socket_path, const char *name,
+                                     broker_reply &reply)
+{
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+        return -1;
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    size_t name_len = strlen(name);
+    if (name_len > size_t(broker_max_name)) {
+        close(sock);
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    if (connect(sock, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+        send(sock, name, name_len, 0) != ssize_t(name_len)) {
+        int e = errno;
+        close(sock);
+        errno = e;
+        return -1;
+    }
+
+    iovec iov = { &reply, sizeof(reply) };
+    union {
+        cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    int e = errno;
+    close(sock);
+    if (n != sizeof(reply)) {
+        errno = n < 0 ? e : EPROTO;
+        return -1;
+    }
+    if (reply.status != 0) {
+        errno = reply.status;
+        return -1;
+    }
+
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        errno = EPROTO;
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+    return fd;
+}
+
+
+// Set the lines selected by mask to the matching bits of bits.
+static inline int broker_set_values(int fd, uint64_t bits, uint64_t mask)
+{
+    gpio_v2_line_values values;
+    values.bits = bits;
+    values.mask = mask;
+    return ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+}
+
+
+// Read the lines selected by mask into bits.
+static inline int broker_get_values(int fd, uint64_t mask, uint64_t &bits)
+{
+    gpio_v2_line_values values;
+    values.bits = 0;
+    values.mask = mask;
+    int r = ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values);
+    bits = values.bits;
+    return r;
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary capture file for edge events.
+//
+// The file is a capture_header followed by fixed-size capture_records.
+// The header describes everything needed to interpret the records (chip,
+// line offsets, debounce, clock), so a file can be read without knowing
+// how it was made. All fields are little-endian (native on the Pi).
+//
+// Records are 16 bytes. To get there, the line is stored as an index into
+// the header's offsets[] and only the low 16 bits of the line seqno are
+// kept; a reader recovers the full line seqno by counting wraps per line
+// (see capture_reader::line_seqno).
+//
+// The writer maps the file and appends records with plain stores. Space is
+// preallocated in chunks and the mapping grown as needed; at close the
+// file is truncated to the records actually written.
+
+static const char capture_magic[8] = { 'G', 'P', 'I', 'O', 'C', 'A', 'P', '1' };
+static const uint32_t capture_version = 1;
+static const int capture_max_lines = 64;
+
+struct capture_header {
+    char magic[8];              // capture_magic
+    uint32_t version;           // capture_version
+    uint32_t header_size;       // sizeof(capture_header)
+    uint32_t record_size;       // sizeof(capture_record)
+    uint32_t num_offsets;       // valid entries in offsets[]
+    uint64_t record_count;      // records in file, updated as they are written
+    char chip_path[64];
+    char chip_name[32];
+    char chip_label[32];
+    uint32_t chip_num_lines;    // lines on the chip (not just the ones captured)
+    uint32_t debounce_us;
+    uint32_t event_clock;       // enum gpiod_line_clock
+    uint32_t reserved;
+    uint64_t start_realtime_ns; // wall clock when capture started
+    uint64_t start_monotonic_ns;// same instant on the event clock (if monotonic)
+    uint32_t offsets[capture_max_lines];
+};
+
+struct capture_record {
+    uint64_t timestamp_ns;
+    uint32_t global_seqno;
+    uint16_t line_seqno;        // low 16 bits
+    uint8_t line_index;         // index into capture_header::offsets[]
+    uint8_t rising;             // 1 for rising edge, 0 for falling
+};
+
+static_assert(sizeof(capture_record) == 16, "capture_record must be 16 bytes");
+static_assert(sizeof(capture_header) % sizeof(capture_record) == 0,
+              "records must stay aligned after the header");
+
+
+// Append-only writer. Usage: open(), fill in header() except the fields
+// open() sets, append() records, close().
+class capture_writer
+{
+public:
+
+    capture_writer() : _fd(-1), _map(nullptr), _map_size(0), _count(0), _capacity(0) { }
+
+    ~capture_writer() { close(); }
+
+    // chunk is how much to preallocate at a time (bytes)
+    bool open(const char *path, size_t chunk = 16 * 1024 * 1024)
+    {
+        _chunk = chunk;
+        _fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (_fd < 0)
+            return false;
+        if (!grow()) {
+            ::close(_fd);
+            _fd = -1;
+            return false;
+        }
+        capture_header *hdr = header();
+        memset(hdr, 0, sizeof(*hdr));
+        memcpy(hdr->magic, capture_magic, sizeof(hdr->magic));
+        hdr->version = capture_version;
+        hdr->header_size = sizeof(capture_header);
+        hdr->record_size = sizeof(capture_record);
+        return true;
+    }
+
+    capture_header *header() { return (capture_header *)_map; }
+
+    // Returns a pointer to the next record to fill in, or nullptr if the
+    // file could not be grown. The record is not counted until commit().
+    capture_record *next()
+    {
+        if (_count == _capacity && !grow())
+            return nullptr;
+        return records() + _count;
+    }
+
+    // Count records filled in since the last commit. Updating the header
+    // count here means a capture that is killed is still readable.
+    void commit(uint64_t n = 1)
+    {
+        _count += n;
+        header()->record_count = _count;
+    }
+
+    bool append(const capture_record &rec)
+    {
+        capture_record *r = next();
+        if (r == nullptr)
+            return false;
+        *r = rec;
+        commit();
+        return true;
+    }
+
+    uint64_t count() const { return _count; }
+
+    void close()
+    {
+        if (_fd < 0)
+            return;
+        header()->record_count = _count;
+        munmap(_map, _map_size);
+        _map = nullptr;
+        // drop the preallocated-but-unused tail
+        int r = ftruncate(_fd, sizeof(capture_header) + _count * sizeof(capture_record));
+        (void)r;
+        ::close(_fd);
+        _fd = -1;
+    }
+
+private:
+
+    capture_record *records()
+    {
+        return (capture_record *)((char *)_map + sizeof(capture_header));
+    }
+
+    // Extend the file by one chunk, allocating the blocks now so page
+    // faults on new records don't wait on the filesystem, then extend the
+    // mapping to cover it.
+    bool grow()
+    {
+        size_t new_size = _map_size + _chunk;
+        if (posix_fallocate(_fd, 0, new_size) != 0)
+            return false;
+        void *p;
+        if (_map == nullptr)
+            p = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        else
+            p = mremap(_map, _map_size, new_size, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED)
+            return false;
+        _map = p;
+        _map_size = new_size;
+        _capacity = (_map_size - sizeof(capture_header)) / sizeof(capture_record);
+        return true;
+    }
+
+    int _fd;
+    void *_map;
+    size_t _map_size;
+    size_t _chunk;
+    uint64_t _count;
+    uint64_t _capacity;
+
+}; // class capture_writer
+
+
+// Read-only view of a capture file.
+class capture_reader
+{
+public:
+
+    capture_reader() : _fd(-1), _map(nullptr), _map_size(0), _count(0)
+    {
+        memset(_seqno_hi, 0, sizeof(_seqno_hi));
+        memset(_seqno_last, 0, sizeof(_seqno_last));
+    }
+
+    ~capture_reader() { close(); }
+
+    bool open(const char *path)
+    {
+        _fd = ::open(path, O_RDONLY);
+        if (_fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(_fd, &st) != 0 || size_t(st.st_size) < sizeof(capture_header)) {
+            close();
+            return false;
+        }
+        _map_size = st.st_size;
+        _map = mmap(nullptr, _map_size, PROT_READ, MAP_SHARED, _fd, 0);
+        if (_map == MAP_FAILED) {
+            _map = nullptr;
+            close();
+            return false;
+        }
+        madvise(_map, _map_size, MADV_SEQUENTIAL);
+        const capture_header *hdr = header();
+        if (memcmp(hdr->magic, capture_magic, sizeof(hdr->magic)) != 0 ||
+            hdr->version != capture_version ||
+            hdr->header_size != sizeof(capture_header) ||
+            hdr->record_size != sizeof(capture_record) ||
+            hdr->num_offsets > capture_max_lines) {
+            close();
+            return false;
+        }
+        // Trust the file size over the header if the writer didn't get to
+        // update the count (or didn't get to truncate).
+        _count = (_map_size - sizeof(capture_header)) / sizeof(capture_record);
+        if (hdr->record_count < _count)
+            _count = hdr->record_count;
+        return true;
+    }
+
+    void close()
+    {
+        if (_map != nullptr)
+            munmap(_map, _map_size);
+        _map = nullptr;
+        if (_fd >= 0)
+            ::close(_fd);
+        _fd = -1;
+    }
+
+    const capture_header *header() const { return (const capture_header *)_map; }
+
+    uint64_t count() const { return _count; }
+
+    const capture_record *records() const
+    {
+        return (const capture_record *)((const char *)_map + sizeof(capture_header));
+    }
+
+    // Full line seqno for a record. Must be called for each record of a
+    // line in order, since it tracks wraps of the stored 16 bits.
+    uint64_t line_seqno(const capture_record &rec)
+    {
+        unsigned i = rec.line_index;
+        assert(i < capture_max_lines);
+        if (rec.line_seqno < _seqno_last[i])
+            _seqno_hi[i] += 0x10000;
+        _seqno_last[i] = rec.line_seqno;
+        return _seqno_hi[i] | rec.line_seqno;
+    }
+
+private:
+
+    int _fd;
+    void *_map;
+    size_t _map_size;
+    uint64_t _count;
+    uint64_t _seqno_hi[capture_max_lines];
+    uint16_t _seqno_last[capture_max_lines];
+
+}; // class capture_reader
@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <cstring>
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+#include "capture.h"
+
+// Read a capture file written by input_events_capture.
+//
+// With no options, prints the header and a summary (events per line,
+// seqno gaps, time span) along with how fast the file was scanned. With
+// -p, also prints every event in the same format input_events uses.
+//
+// Usage: capture_read [-p] <file>
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    bool print_events = false;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0)
+            print_events = true;
+        else
+            path = argv[i];
+    }
+
+    if (path == nullptr) {
+        fprintf(stderr, "usage: %s [-p] <capture file>\n", argv[0]);
+        return 1;
+    }
+
+    capture_reader capture;
+    if (!capture.open(path)) {
+        fprintf(stderr, "%s: %s is not a readable capture file\n", argv[0], path);
+        return 1;
+    }
+
+    const capture_header *hdr = capture.header();
+    const unsigned num_lines = hdr->num_offsets;
+
+    printf("chip %s (%s, %s, %u lines)\n", hdr->chip_path, hdr->chip_name,
+           hdr->chip_label, hdr->chip_num_lines);
+    printf("lines");
+    for (unsigned i = 0; i < num_lines; i++)
+        printf(" %u", hdr->offsets[i]);
+    printf("\n");
+    printf("debounce time = %u usec\n", hdr->debounce_us);
+    printf("events = %" PRIu64 "\n", capture.count());
+
+    // per-line counters, indexed by line_index
+    uint64_t rising[capture_max_lines] = { 0 };
+    uint64_t falling[capture_max_lines] = { 0 };
+    uint64_t line_gaps[capture_max_lines] = { 0 };
+    uint64_t line_last[capture_max_lines] = { 0 };
+    uint64_t global_gaps = 0;
+    uint64_t bad_index = 0;
+
+    const capture_record *rec = capture.records();
+    const uint64_t count = capture.count();
+    uint64_t last_ns = 0;
+
+    uint64_t start_ns = now_ns();
+
+    for (uint64_t n = 0; n < count; n++, rec++) {
+
+        unsigned li = rec->line_index;
+        if (li >= num_lines) {
+            bad_index++;
+            continue;
+        }
+
+        if (rec->rising)
+            rising[li]++;
+        else
+            falling[li]++;
+
+        // Seqnos start at 1, so a zero 'last' means first event seen.
+        uint64_t line_seqno = capture.line_seqno(*rec);
+        if (line_last[li] != 0 && line_seqno != line_last[li] + 1)
+            line_gaps[li] += line_seqno - line_last[li] - 1;
+        line_last[li] = line_seqno;
+
+        if (n > 0 && rec->global_seqno != rec[-1].global_seqno + 1)
+            global_gaps += uint32_t(rec->global_seqno - rec[-1].global_seqno - 1);
+
+        if (print_events) {
+            printf("%" PRIu32 ":%" PRIu64 " pin %u = %u @ %" PRIu64,
+                   rec->global_seqno, line_seqno, hdr->offsets[li], rec->rising,
+                   rec->timestamp_ns);
+            if (last_ns != 0)
+                printf(" +%" PRIu64, rec->timestamp_ns - last_ns);
+            last_ns = rec->timestamp_ns;
+            printf("\n");
+        }
+
+    } // for
+
+    uint64_t scan_ns = now_ns() - start_ns;
+
+    for (unsigned i = 0; i < num_lines; i++)
+        printf("pin %u: %" PRIu64 " rising, %" PRIu64 " falling, %" PRIu64 " missed\n",
+               hdr->offsets[i], rising[i], falling[i], line_gaps[i]);
+    printf("global seqno gaps: %" PRIu64 " events missed\n", global_gaps);
+    if (bad_index != 0)
+        printf("bad line index: %" PRIu64 " records\n", bad_index);
+
+    if (count > 0) {
+        const capture_record *recs = capture.records();
+        double span_s = (recs[count - 1].timestamp_ns - recs[0].timestamp_ns) / 1e9;
+        printf("span = %.6f sec (%.1f events/sec)\n", span_s,
+               span_s > 0 ? count / span_s : 0.0);
+    }
+
+    if (!print_events && scan_ns > 0)
+        printf("scanned in %.3f msec (%.1f M events/sec)\n", scan_ns / 1e6,
+               count * 1e3 / scan_ns);
+
+    return 0;
+
+} // main
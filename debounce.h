@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+
+// Userspace debounce for one line, fed with undebounced edge events.
+//
+// Three algorithms:
+//
+//   lockout     The first edge that changes the output is passed through
+//               at once (no added latency), then further edges are
+//               ignored for the period. If the line ended up at the other
+//               level when the lockout ends, that change is passed then.
+//   integrator  A counter runs up while the line is high and down while
+//               it is low, clamped to [0, period]; the output changes when
+//               the counter reaches the end. Brief glitches are filtered
+//               in proportion to their length instead of restarting the
+//               whole period. Worked out from the edge times, not sampled.
+//   stable      The output changes once the line has not changed for the
+//               period. This is what the kernel's debounce_period_us does.
+//
+// edge() takes each raw edge. Output changes are either produced by edge()
+// (lockout only) or become due at deadline(); call expire() with the
+// current time before each edge() and whenever deadline() passes.
+//
+// Each output change has the time it was decided and the time of the raw
+// edge that started it, so the latency added by debouncing is the
+// difference.
+
+class debouncer
+{
+public:
+
+    enum algorithm { lockout, integrator, stable };
+
+    struct output {
+        bool level;
+        uint64_t decided_ns;    // when the debounced edge happened
+        uint64_t source_ns;     // raw edge that started the change
+    };
+
+    debouncer() { init(stable, 0, false); }
+
+    void init(algorithm algo, uint64_t period_ns, bool level, uint64_t now_ns = 0)
+    {
+        _algo = algo;
+        _period_ns = period_ns;
+        _raw = level;
+        _out = level;
+        _last_ns = now_ns;
+        _start_ns = now_ns;
+        _lock_until_ns = 0;
+        _acc_ns = level ? period_ns : 0;
+    }
+
+    algorithm get_algorithm() const { return _algo; }
+    bool level() const { return _out; }
+
+    // Raw edge to 'level' at timestamp_ns. Returns true (and fills in out)
+    // if the output changes right now.
+    bool edge(bool level, uint64_t timestamp_ns, output &out)
+    {
+        if (_algo == integrator)
+            integrate(timestamp_ns);
+
+        // the first raw edge away from the output starts a change
+        if (_raw == _out && level != _out)
+            _start_ns = timestamp_ns;
+
+        _raw = level;
+        _last_ns = timestamp_ns;
+
+        if (_algo == lockout && timestamp_ns >= _lock_until_ns && _raw != _out) {
+            _out = _raw;
+            _lock_until_ns = timestamp_ns + _period_ns;
+            out.level = _out;
+            out.decided_ns = timestamp_ns;
+            out.source_ns = timestamp_ns;
+            return true;
+        }
+
+        return false;
+    }
+
+    // When a pending output change is due, or UINT64_MAX if none is.
+    uint64_t deadline() const
+    {
+        if (_raw == _out)
+            return UINT64_MAX;
+        switch (_algo) {
+        case lockout:
+            return _lock_until_ns;
+        case integrator:
+            return _last_ns + (_raw ? _period_ns - _acc_ns : _acc_ns);
+        case stable:
+        default:
+            return _last_ns + _period_ns;
+        }
+    }
+
+    // If the pending change is due by now_ns, make it and return true.
+    bool expire(uint64_t now_ns, output &out)
+    {
+        uint64_t due_ns = deadline();
+        if (due_ns == UINT64_MAX || due_ns > now_ns)
+            return false;
+        _out = _raw;
+        out.level = _out;
+        out.decided_ns = due_ns;
+        out.source_ns = _start_ns;
+        if (_algo == lockout) {
+            _lock_until_ns = due_ns + _period_ns;
+        } else if (_algo == integrator) {
+            _acc_ns = _out ? _period_ns : 0;
+            _last_ns = due_ns;
+        }
+        return true;
+    }
+
+private:
+
+    // Bring the integrator up to timestamp_ns at the current raw level.
+    void integrate(uint64_t timestamp_ns)
+    {
+        uint64_t dt = timestamp_ns - _last_ns;
+        if (_raw)
+            _acc_ns = (_period_ns - _acc_ns > dt) ? _acc_ns + dt : _period_ns;
+        else
+            _acc_ns = (_acc_ns > dt) ? _acc_ns - dt : 0;
+    }
+
+    algorithm _algo;
+    uint64_t _period_ns;
+    bool _raw;              // last raw level
+    bool _out;              // debounced level
+    uint64_t _last_ns;      // time of last raw edge (or integrator update)
+    uint64_t _start_ns;     // first raw edge of the pending change
+    uint64_t _lock_until_ns;
+    uint64_t _acc_ns;       // integrator, 0..period
+
+}; // class debouncer
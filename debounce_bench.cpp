@@ -0,0 +1,427 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "capture.h"
+#include "debounce.h"
+#include "histogram.h"
+
+// Compare debounce algorithms on the same bounce streams.
+//
+// The streams come from a raw capture (input_events_capture <file> 0) or,
+// with no file, from a synthetic switch: each press or release bounces 0
+// to 8 times, 10 to 300 usec apart, then stays put for 5 to 50 msec.
+//
+// Each stream is replayed through the userspace lockout, integrator and
+// stable debouncers. For each: output edges, added latency (output edge
+// time minus the raw edge that started it) and userspace CPU time per raw
+// edge.
+//
+// Kernel debounce (debounce_period_us) can only be measured on real
+// lines, so it is an opt-in mode: with -k, wire an output to an input on
+// the same chip. The first -n edges of line 0 are driven on the output at
+// their recorded spacing, while the input is requested with edge events
+// and the kernel debouncing them; the events it delivers are the "kernel"
+// row. Its latency is the event timestamp (taken when the kernel's
+// debounce period expires) minus the time the first edge of that change
+// was driven. Driving from userspace can't reproduce spacing much under
+// 100 usec, so the edges as actually driven are also run through the
+// userspace stable debouncer ("stable*"), which is the row to compare it
+// with. The kernel's CPU time is spent in interrupt and workqueue context
+// and isn't charged to this process, so there's no CPU figure for it;
+// what userspace saves is reading every raw edge.
+//
+// Usage: debounce_bench [-f <capture file>] [-k chip:out,in [-n edges]]
+//                       [period_us]   (default 1000)
+//
+//   -n   edges to drive in -k mode, default 2000 (about 10 seconds of the
+//        synthetic stream)
+
+static const int synth_transitions = 100000;
+static const int timing_passes = 20;
+
+static const int max_events = 64;   // loopback mode: events per read
+
+struct raw_edge {
+    uint64_t timestamp_ns;
+    uint8_t line;
+    uint8_t level;
+};
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static raw_edge *synthesize(uint64_t &num_edges, unsigned &num_lines)
+{
+    // at most 9 raw edges per transition (8 bounces + final)
+    raw_edge *edges = new raw_edge[synth_transitions * 9];
+    srandom(1);
+    uint64_t ts = 1000000000;
+    bool level = false;
+    uint64_t n = 0;
+    for (int t = 0; t < synth_transitions; t++) {
+        level = !level;
+        int bounces = random() % 9;
+        // an even number of extra edges, so the stream ends at 'level'
+        bounces &= ~1;
+        bool l = level;
+        for (int b = 0; b <= bounces; b++) {
+            edges[n].timestamp_ns = ts;
+            edges[n].line = 0;
+            edges[n].level = l;
+            n++;
+            l = !l;
+            ts += 10000 + random() % 290000;
+        }
+        ts += 5000000 + random() % 45000000;
+    }
+    num_edges = n;
+    num_lines = 1;
+    return edges;
+}
+
+
+static raw_edge *load_capture(const char *path, uint64_t &num_edges, unsigned &num_lines)
+{
+    capture_reader capture;
+    if (!capture.open(path)) {
+        fprintf(stderr, "%s is not a readable capture file\n", path);
+        exit(1);
+    }
+    if (capture.header()->debounce_us != 0)
+        fprintf(stderr, "warning: %s was captured with %u usec kernel debounce\n", path,
+                capture.header()->debounce_us);
+    num_edges = capture.count();
+    num_lines = capture.header()->num_offsets;
+    raw_edge *edges = new raw_edge[num_edges];
+    const capture_record *rec = capture.records();
+    for (uint64_t i = 0; i < num_edges; i++) {
+        edges[i].timestamp_ns = rec[i].timestamp_ns;
+        edges[i].line = rec[i].line_index;
+        edges[i].level = rec[i].rising;
+    }
+    return edges;
+}
+
+
+struct run_result {
+    uint64_t outputs;
+    histogram<> latency;
+};
+
+
+// Replay all edges through one debouncer per line.
+static void run(debouncer::algorithm algo, uint64_t period_ns, const raw_edge *edges,
+                uint64_t num_edges, unsigned num_lines, run_result *result)
+{
+    debouncer deb[capture_max_lines];
+    bool started[capture_max_lines] = { false };
+    debouncer::output out;
+
+    if (result != nullptr) {
+        result->outputs = 0;
+        result->latency.reset();
+    }
+
+    for (uint64_t i = 0; i < num_edges; i++) {
+        const raw_edge &e = edges[i];
+        debouncer &d = deb[e.line];
+        if (!started[e.line]) {
+            // the line was at the other level before its first edge
+            d.init(algo, period_ns, !e.level, e.timestamp_ns);
+            started[e.line] = true;
+        }
+        if (d.expire(e.timestamp_ns, out) && result != nullptr) {
+            result->outputs++;
+            result->latency.record(out.decided_ns - out.source_ns);
+        }
+        if (d.edge(e.level, e.timestamp_ns, out) && result != nullptr) {
+            result->outputs++;
+            result->latency.record(out.decided_ns - out.source_ns);
+        }
+    }
+
+    // let anything still pending finish
+    for (unsigned l = 0; l < num_lines; l++)
+        if (started[l] && deb[l].expire(UINT64_MAX - 1, out) && result != nullptr) {
+            result->outputs++;
+            result->latency.record(out.decided_ns - out.source_ns);
+        }
+}
+
+
+static void sleep_until(uint64_t t_ns)
+{
+    timespec ts;
+    ts.tv_sec = t_ns / 1000000000;
+    ts.tv_nsec = t_ns % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+}
+
+
+// "chip:out,in"
+static bool parse_loopback(const char *arg, char *chip_path, size_t chip_len,
+                           unsigned int &out_offset, unsigned int &in_offset)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || size_t(colon - arg) >= chip_len)
+        return false;
+    memcpy(chip_path, arg, colon - arg);
+    chip_path[colon - arg] = '\0';
+    char *end;
+    out_offset = strtoul(colon + 1, &end, 0);
+    if (end == colon + 1 || *end != ',')
+        return false;
+    const char *p = end + 1;
+    in_offset = strtoul(p, &end, 0);
+    return end != p && *end == '\0' && in_offset != out_offset;
+}
+
+
+// Kernel debounce output matched against the edges driven so far.
+struct loopback_state {
+    const raw_edge *driven;
+    uint64_t num_driven;
+    uint64_t train;             // first driven edge after the last output
+};
+
+
+// Read whatever debounced events are ready (or wait up to timeout_ns for
+// some) and record them.
+static void read_kernel_events(gpiod_line_request *request, gpiod_edge_event_buffer *events,
+                               int64_t timeout_ns, loopback_state &st, run_result &result)
+{
+    while (gpiod_line_request_wait_edge_events(request, timeout_ns) == 1) {
+        int n = gpiod_line_request_read_edge_events(request, events, max_events);
+        assert(n > 0);
+        for (int i = 0; i < n; i++) {
+            gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+            uint64_t t = gpiod_edge_event_get_timestamp_ns(event);
+            uint64_t source_ns = st.train < st.num_driven ? st.driven[st.train].timestamp_ns : t;
+            result.outputs++;
+            result.latency.record(t > source_ns ? t - source_ns : 0);
+            while (st.train < st.num_driven && st.driven[st.train].timestamp_ns <= t)
+                st.train++;
+        }
+        timeout_ns = 0;
+    }
+}
+
+
+// Drive line 0's edges (at most max_edges) on out_offset at their
+// recorded spacing, with in_offset requested with kernel debounce of
+// period_us, and collect what the kernel delivers. The edges as driven
+// (when each set returned) go in driven[]. Returns false if the lines
+// can't be had.
+static bool replay_kernel(const char *chip_path, unsigned int out_offset,
+                          unsigned int in_offset, unsigned long period_us,
+                          const raw_edge *edges, uint64_t num_edges, uint64_t max_edges,
+                          raw_edge *driven, uint64_t &num_driven, run_result &result)
+{
+    uint64_t first = 0;
+    while (first < num_edges && edges[first].line != 0)
+        first++;
+    if (first == num_edges)
+        return false;
+
+    // output starts at the level line 0 had before its first edge
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+    gpiod_line_settings_set_output_value(settings, edges[first].level
+                                         ? GPIOD_LINE_VALUE_INACTIVE : GPIOD_LINE_VALUE_ACTIVE);
+    int r1 = gpiod_line_config_add_line_settings(line_config, &out_offset, 1, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_reset(settings);
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_debounce_period_us(settings, period_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+    int r2 = gpiod_line_config_add_line_settings(line_config, &in_offset, 1, settings);
+    assert(r2 == 0);
+
+    gpiod_line_settings_free(settings);
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    if (chip == nullptr) {
+        gpiod_line_config_free(line_config);
+        return false;
+    }
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, nullptr, line_config);
+    gpiod_line_config_free(line_config);
+    gpiod_chip_close(chip);
+    if (request == nullptr)
+        return false;
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    result.outputs = 0;
+    result.latency.reset();
+    num_driven = 0;
+    loopback_state st = { driven, 0, 0 };
+
+    // let the input settle, and throw away anything from that
+    const int64_t settle_ns = int64_t(period_us) * 1000 * 2 + 10000000;
+    static run_result ignored;
+    read_kernel_events(request, events, settle_ns, st, ignored);
+
+    const uint64_t t0_ns = now_ns() + 10000000;
+    const uint64_t base_ns = edges[first].timestamp_ns;
+
+    for (uint64_t i = first; i < num_edges && num_driven < max_edges; i++) {
+        const raw_edge &e = edges[i];
+        if (e.line != 0)
+            continue;
+        uint64_t due_ns = t0_ns + (e.timestamp_ns - base_ns);
+
+        // collect what's come in while waiting
+        int64_t wait_ns = int64_t(due_ns - now_ns());
+        if (wait_ns > 0)
+            read_kernel_events(request, events, 0, st, result);
+        sleep_until(due_ns);
+
+        int r3 = gpiod_line_request_set_value(request, out_offset, e.level
+                                              ? GPIOD_LINE_VALUE_ACTIVE
+                                              : GPIOD_LINE_VALUE_INACTIVE);
+        assert(r3 == 0);
+        driven[num_driven].timestamp_ns = now_ns();
+        driven[num_driven].line = 0;
+        driven[num_driven].level = e.level;
+        num_driven++;
+        st.num_driven = num_driven;
+    }
+
+    // the last change comes out one period after the last edge
+    read_kernel_events(request, events, settle_ns, st, result);
+
+    gpiod_edge_event_buffer_free(events);
+    gpiod_line_request_release(request);
+
+    return true;
+}
+
+
+// cpu_ns_per_edge < 0: not measured
+static void print_row(const char *name, const run_result &result, double cpu_ns_per_edge)
+{
+    printf("%-11s %10" PRIu64 " %10.1f %10.1f %10.1f ", name, result.outputs,
+           result.latency.percentile(50) / 1e3, result.latency.percentile(99) / 1e3,
+           result.latency.max() / 1e3);
+    if (cpu_ns_per_edge < 0.0)
+        printf("%10s\n", "-");
+    else
+        printf("%10.2f\n", cpu_ns_per_edge);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    const char *path = nullptr;
+    unsigned long period_us = 1000;
+    const char *loopback_arg = nullptr;
+    uint64_t drive_edges = 2000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            path = argv[++i];
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+            loopback_arg = argv[++i];
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            drive_edges = strtoull(argv[++i], nullptr, 0);
+        else
+            period_us = strtoul(argv[i], nullptr, 0);
+    }
+    const uint64_t period_ns = uint64_t(period_us) * 1000;
+
+    char loopback_chip[64];
+    unsigned int out_offset = 0, in_offset = 0;
+    if (loopback_arg != nullptr &&
+        (!parse_loopback(loopback_arg, loopback_chip, sizeof(loopback_chip), out_offset,
+                         in_offset) || drive_edges == 0)) {
+        fprintf(stderr, "usage: %s [-f <capture file>] [-k chip:out,in [-n edges]]"
+                " [period_us]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t num_edges;
+    unsigned num_lines;
+    raw_edge *edges = path ? load_capture(path, num_edges, num_lines)
+                           : synthesize(num_edges, num_lines);
+
+    if (num_edges == 0 || num_lines > capture_max_lines) {
+        fprintf(stderr, "nothing to replay\n");
+        return 1;
+    }
+
+    printf("%" PRIu64 " raw edges on %u lines (%s), period %lu usec\n", num_edges,
+           num_lines, path ? path : "synthetic", period_us);
+    printf("%-11s %10s %10s %10s %10s %10s\n", "", "outputs",
+           "p50 us", "p99 us", "max us", "cpu ns/edge");
+
+    static const struct {
+        const char *name;
+        debouncer::algorithm algo;
+    } runs[] = {
+        { "lockout",    debouncer::lockout    },
+        { "integrator", debouncer::integrator },
+        { "stable",     debouncer::stable     },
+    };
+
+    static run_result result;
+
+    for (const auto &r : runs) {
+
+        run(r.algo, period_ns, edges, num_edges, num_lines, &result);
+
+        // Time the userspace work without the statistics.
+        uint64_t best_ns = UINT64_MAX;
+        for (int p = 0; p < timing_passes; p++) {
+            uint64_t start_ns = now_ns();
+            run(r.algo, period_ns, edges, num_edges, num_lines, nullptr);
+            uint64_t elapsed_ns = now_ns() - start_ns;
+            if (elapsed_ns < best_ns)
+                best_ns = elapsed_ns;
+        }
+
+        print_row(r.name, result, double(best_ns) / num_edges);
+    }
+
+    if (loopback_arg != nullptr) {
+        raw_edge *driven = new raw_edge[drive_edges];
+        uint64_t num_driven = 0;
+        if (replay_kernel(loopback_chip, out_offset, in_offset, period_us, edges, num_edges,
+                          drive_edges, driven, num_driven, result)) {
+            printf("loopback: %" PRIu64 " edges driven on %s %u -> %u\n", num_driven,
+                   loopback_chip, out_offset, in_offset);
+            // kernel row first; run() reuses 'result'
+            print_row("kernel", result, -1.0);
+            run(debouncer::stable, period_ns, driven, num_driven, 1, &result);
+            print_row("stable*", result, -1.0);
+        } else {
+            printf("loopback: can't use %s lines %u and %u: %s\n", loopback_chip, out_offset,
+                   in_offset, strerror(errno));
+        }
+        delete[] driven;
+    }
+
+    delete[] edges;
+
+    return 0;
+
+} // main
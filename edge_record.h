@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <gpiod.h>
+
+// Plain copy of the interesting fields of a gpiod_edge_event. The gpiod
+// event objects live inside an edge event buffer that is overwritten by
+// the next read, so anything that wants to keep events around (another
+// thread, a file) copies them into one of these first.
+struct edge_record {
+    uint64_t timestamp_ns;
+    uint32_t global_seqno;  // kernel seqnos are 32 bits
+    uint32_t line_seqno;
+    uint32_t offset;
+    uint32_t rising;        // 1 for rising edge, 0 for falling
+};
+
+static inline void edge_record_set(edge_record &rec, gpiod_edge_event *event)
+{
+    rec.timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+    rec.global_seqno = gpiod_edge_event_get_global_seqno(event);
+    rec.line_seqno = gpiod_edge_event_get_line_seqno(event);
+    rec.offset = gpiod_edge_event_get_line_offset(event);
+    rec.rising =
+        gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <vector>
+#include <gpiod.h>
+
+// Watch any number of line requests (on any number of chips) from one
+// thread with one epoll set.
+//
+// Each request's fd (gpiod_line_request_get_fd) is added to the epoll set
+// along with a handler. run_once() waits for any of the fds to become
+// readable, reads the edge events for each ready request into a shared
+// event buffer, and calls that request's handler. The handler must finish
+// with the events before returning since the buffer is reused.
+//
+// The epoll set is level-triggered, so a request that had more events
+// than fit in the buffer is simply reported ready again next time.
+
+class event_reactor
+{
+public:
+
+    typedef void (*handler_fn)(gpiod_line_request *request,
+                               gpiod_edge_event_buffer *events,
+                               int num_events, void *arg);
+
+    event_reactor(size_t max_events = 32) : _max_events(max_events)
+    {
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        assert(_epoll_fd >= 0);
+        _events = gpiod_edge_event_buffer_new(_max_events);
+        assert(_events != nullptr);
+    }
+
+    ~event_reactor()
+    {
+        for (entry *e : _entries)
+            delete e;
+        gpiod_edge_event_buffer_free(_events);
+        close(_epoll_fd);
+    }
+
+    // Start watching request. Returns false if the fd can't be added.
+    bool add(gpiod_line_request *request, handler_fn handler, void *arg)
+    {
+        entry *e = new entry { request, handler, arg };
+        epoll_event ev = { };
+        ev.events = EPOLLIN;
+        ev.data.ptr = e;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, gpiod_line_request_get_fd(request), &ev) != 0) {
+            delete e;
+            return false;
+        }
+        _entries.push_back(e);
+        return true;
+    }
+
+    // Stop watching request (call before releasing it).
+    void remove(gpiod_line_request *request)
+    {
+        for (size_t i = 0; i < _entries.size(); i++) {
+            if (_entries[i]->request == request) {
+                epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, gpiod_line_request_get_fd(request), nullptr);
+                delete _entries[i];
+                _entries.erase(_entries.begin() + i);
+                return;
+            }
+        }
+    }
+
+    size_t size() const { return _entries.size(); }
+
+    // Wait up to timeout_ms (-1 forever) for events on any request and
+    // dispatch them. Returns the number of events handled, 0 on timeout,
+    // or -1 on error (errno set; EINTR for a signal).
+    int run_once(int timeout_ms = -1)
+    {
+        epoll_event ready[max_ready];
+        int n = epoll_wait(_epoll_fd, ready, max_ready, timeout_ms);
+        if (n <= 0)
+            return n;
+        int handled = 0;
+        for (int i = 0; i < n; i++) {
+            entry *e = (entry *)ready[i].data.ptr;
+            int num_events = gpiod_line_request_read_edge_events(e->request, _events, _max_events);
+            if (num_events < 0)
+                return -1;
+            e->handler(e->request, _events, num_events, e->arg);
+            handled += num_events;
+        }
+        return handled;
+    }
+
+private:
+
+    static const int max_ready = 16; // requests serviced per wakeup
+
+    struct entry {
+        gpiod_line_request *request;
+        handler_fn handler;
+        void *arg;
+    };
+
+    int _epoll_fd;
+    size_t _max_events;
+    gpiod_edge_event_buffer *_events;
+    std::vector<entry *> _entries;
+
+}; // class event_reactor
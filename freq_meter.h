@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+// Frequency, period, high/low time and duty cycle of one input, measured
+// from edge timestamps by reciprocal counting.
+//
+// Instead of counting edges in a fixed gate time (which has +/-1 count of
+// error, bad at low frequencies), this measures the time spanned by a
+// whole number of periods: from the first rising edge in the window to
+// the last one. The next window starts at the last rising edge of the one
+// before, so no time is lost between windows.
+//
+// High and low times are summed from each rising->falling and
+// falling->rising pair, so duty cycle is averaged over the same window.
+//
+// Feed every edge to edge(), and call take() at the report rate.
+
+class freq_meter
+{
+public:
+
+    struct result {
+        uint64_t periods;   // whole periods measured (0 = no result)
+        double freq_hz;
+        double period_ns;
+        double min_period_ns;
+        double max_period_ns;
+        double high_ns;     // average high time
+        double low_ns;      // average low time
+        double duty;        // high / (high + low), 0..1
+    };
+
+    freq_meter() : _have_rise(false), _have_edge(false), _last_edge_ns(0), _last_rise_ns(0)
+    {
+        start_window();
+    }
+
+    void edge(bool rising, uint64_t timestamp_ns)
+    {
+        if (_have_edge) {
+            uint64_t dt = timestamp_ns - _last_edge_ns;
+            if (rising) {
+                _low_ns += dt;      // was low until now
+                _lows++;
+            } else {
+                _high_ns += dt;
+                _highs++;
+            }
+        }
+        _have_edge = true;
+        _last_edge_ns = timestamp_ns;
+
+        if (!rising)
+            return;
+
+        if (_have_rise) {
+            uint64_t period = timestamp_ns - _last_rise_ns;
+            if (period < _min_period_ns)
+                _min_period_ns = period;
+            if (period > _max_period_ns)
+                _max_period_ns = period;
+            _periods++;
+        } else {
+            _have_rise = true;
+        }
+        if (_periods == 0)
+            _first_rise_ns = timestamp_ns;
+        _last_rise_ns = timestamp_ns;
+    }
+
+    // Results for the window since the last take(), and start a new one.
+    // If the window has no complete period (signal slower than the window
+    // or stopped), periods is zero and the window keeps going, so a slow
+    // signal gets measured over however many windows one period takes.
+    result take()
+    {
+        result r = { };
+        if (_periods == 0)
+            return r;
+        r.periods = _periods;
+        r.period_ns = double(_last_rise_ns - _first_rise_ns) / _periods;
+        r.freq_hz = 1e9 / r.period_ns;
+        r.min_period_ns = _min_period_ns;
+        r.max_period_ns = _max_period_ns;
+        r.high_ns = _highs ? double(_high_ns) / _highs : 0.0;
+        r.low_ns = _lows ? double(_low_ns) / _lows : 0.0;
+        r.duty = (_high_ns + _low_ns) ? double(_high_ns) / (_high_ns + _low_ns) : 0.0;
+        start_window();
+        return r;
+    }
+
+private:
+
+    // The new window's first rising edge is the old window's last one.
+    void start_window()
+    {
+        _first_rise_ns = _last_rise_ns;
+        _periods = 0;
+        _min_period_ns = UINT64_MAX;
+        _max_period_ns = 0;
+        _high_ns = 0;
+        _low_ns = 0;
+        _highs = 0;
+        _lows = 0;
+    }
+
+    bool _have_rise;
+    bool _have_edge;
+    uint64_t _last_edge_ns;
+    uint64_t _first_rise_ns;
+    uint64_t _last_rise_ns;
+    uint64_t _periods;
+    uint64_t _min_period_ns;
+    uint64_t _max_period_ns;
+    uint64_t _high_ns;
+    uint64_t _low_ns;
+    uint64_t _highs;
+    uint64_t _lows;
+
+}; // class freq_meter
@@ -0,0 +1,286 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <gpiod.h>
+#include "broker_client.h"
+
+// Line-holding broker. Requests some sets of lines once, at startup, and
+// keeps them. Clients connect to a Unix socket, name a line set, and get
+// a dup of that request's fd (see broker_client.h). Clients skip the chip
+// open and request ioctls, and since the broker never releases the lines,
+// outputs don't glitch between one client and the next.
+//
+// Usage: gpio_broker [-s socket] [name=chip:in|out:offset[,offset...] ...]
+//   e.g. gpio_broker leds=/dev/gpiochip0:out:23,24 keys=/dev/gpiochip0:in:5,6
+//
+// With no line sets, holds GPIO23 and GPIO24 as outputs named "out2".
+// Inputs are requested with pull-ups and edge detection on both edges.
+//
+// Anyone who can connect gets a live request fd, outputs included, so the
+// socket is created with mode 0660: only the broker's user and group can
+// use it. Put the users who may drive the lines in that group.
+
+static const char *default_set = "out2=/dev/gpiochip0:out:23,24";
+
+static const int max_sets = 16;
+
+static const mode_t socket_mode = 0660; // see above
+
+// How long a client has to send the set name after connecting. The broker
+// serves one client at a time, so this is the most one silent client can
+// hold up the others.
+static const int client_timeout_ms = 100;
+
+static volatile sig_atomic_t quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+struct line_set {
+    char name[broker_max_name + 1];
+    char chip_path[64];
+    bool output;
+    unsigned int offsets[broker_max_lines];
+    int num_offsets;
+    gpiod_line_request *request;
+};
+
+
+// Parse "name=chip:in|out:offset,offset,...". Returns false if malformed.
+static bool parse_set(const char *arg, line_set &set)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq == nullptr || eq == arg || eq - arg > broker_max_name)
+        return false;
+    memcpy(set.name, arg, eq - arg);
+    set.name[eq - arg] = '\0';
+
+    const char *chip = eq + 1;
+    const char *colon = strchr(chip, ':');
+    if (colon == nullptr || colon == chip || size_t(colon - chip) >= sizeof(set.chip_path))
+        return false;
+    memcpy(set.chip_path, chip, colon - chip);
+    set.chip_path[colon - chip] = '\0';
+
+    const char *dir = colon + 1;
+    if (strncmp(dir, "in:", 3) == 0)
+        set.output = false;
+    else if (strncmp(dir, "out:", 4) == 0)
+        set.output = true;
+    else
+        return false;
+
+    const char *p = strchr(dir, ':') + 1;
+    set.num_offsets = 0;
+    while (*p != '\0') {
+        char *end;
+        unsigned long offset = strtoul(p, &end, 0);
+        if (end == p || set.num_offsets >= broker_max_lines)
+            return false;
+        set.offsets[set.num_offsets++] = offset;
+        p = end;
+        if (*p == ',')
+            p++;
+        else if (*p != '\0')
+            return false;
+    }
+    return set.num_offsets > 0;
+}
+
+
+static void request_set(line_set &set)
+{
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    if (set.output) {
+        gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+        gpiod_line_settings_set_drive(settings, GPIOD_LINE_DRIVE_PUSH_PULL);
+        gpiod_line_settings_set_output_value(settings, GPIOD_LINE_VALUE_INACTIVE);
+    } else {
+        gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+        gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+        gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+        gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+    }
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, set.offsets,
+                                                 set.num_offsets, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+
+    gpiod_chip *chip = gpiod_chip_open(set.chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "gpio_broker");
+
+    set.request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(set.request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    gpiod_line_config_free(line_config);
+
+    // The request has its own fd.
+    gpiod_chip_close(chip);
+}
+
+
+// Answer one client.
+static void serve(int conn, line_set *sets, int num_sets)
+{
+    timeval tv = { 0, client_timeout_ms * 1000 };
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    char name[broker_max_name + 1];
+    ssize_t n = recv(conn, name, broker_max_name, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        printf("client sent nothing in %d msec; dropped\n", client_timeout_ms);
+    if (n <= 0)
+        return;
+    name[n] = '\0';
+
+    broker_reply reply;
+    memset(&reply, 0, sizeof(reply));
+
+    line_set *set = nullptr;
+    for (int i = 0; i < num_sets; i++)
+        if (strcmp(sets[i].name, name) == 0)
+            set = &sets[i];
+
+    iovec iov = { &reply, sizeof(reply) };
+    union {
+        cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (set == nullptr) {
+        reply.status = ENOENT;
+        printf("client asked for unknown set \"%s\"\n", name);
+    } else {
+        // The offsets in the order the kernel knows them; this is the bit
+        // order for the values ioctls.
+        reply.num_lines = gpiod_line_request_get_requested_offsets(
+                set->request, reply.offsets, broker_max_lines);
+        int fd = gpiod_line_request_get_fd(set->request);
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+    }
+
+    if (sendmsg(conn, &msg, MSG_NOSIGNAL) < 0)
+        perror("sendmsg");
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    const char *socket_path = broker_default_socket;
+    static line_set sets[max_sets];
+    int num_sets = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (num_sets < max_sets && parse_set(argv[i], sets[num_sets])) {
+            num_sets++;
+        } else {
+            fprintf(stderr, "usage: %s [-s socket] [name=chip:in|out:offset[,offset...] ...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (num_sets == 0) {
+        bool ok = parse_set(default_set, sets[num_sets++]);
+        assert(ok);
+    }
+
+    for (int i = 0; i < num_sets; i++) {
+        request_set(sets[i]);
+        printf("%s: %s %s, %d lines\n", sets[i].name, sets[i].chip_path,
+               sets[i].output ? "out" : "in", sets[i].num_offsets);
+    }
+
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    assert(sock >= 0);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    unlink(socket_path); // left over from a previous run
+
+    // The socket file gets its mode from the umask at bind; set it so
+    // there's no window with the socket open to everyone.
+    mode_t old_umask = umask(~socket_mode & 0777);
+    int r2 = bind(sock, (sockaddr *)&addr, sizeof(addr));
+    umask(old_umask);
+
+    if (r2 != 0 || listen(sock, 16) != 0) {
+        fprintf(stderr, "%s: can't listen on %s: %s\n", argv[0], socket_path, strerror(errno));
+        return 1;
+    }
+
+    printf("listening on %s\n", socket_path);
+
+    // ctrl-c sets 'quitting'; no SA_RESTART so accept() returns EINTR
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ctrl_c_handler;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    while (!quitting) {
+
+        int conn = accept4(sock, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("accept");
+            break;
+        }
+
+        serve(conn, sets, num_sets);
+        close(conn);
+
+    } // while
+
+    close(sock);
+    unlink(socket_path);
+
+    for (int i = 0; i < num_sets; i++) {
+        gpiod_line_request_release(sets[i].request);
+        sets[i].request = nullptr;
+    }
+
+    return 0;
+
+} // main
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <gpiod.h>
+
+// Compile-time line sets.
+//
+// The example programs all build their line configuration at run time:
+// settings_new, set each setting, config_new, add_line_settings, maybe
+// set_output_values, then free it all. Here the lines are described as a
+// constexpr line_set instead. Offsets, initial values and value tables
+// are std::arrays computed by the compiler, and the value arrays used in
+// the loop are fixed-size std::arrays sized by the line count, so there
+// is no heap allocation in this code and the line count is known to the
+// compiler everywhere.
+//
+// libgpiod itself still allocates its settings/config/request objects
+// (that's inside the library); request_lines() keeps that to one settings
+// and one config object however many lines there are, and frees them
+// before returning.
+//
+//   static constexpr auto lines = make_line_set(
+//       output_line(23, GPIOD_LINE_VALUE_INACTIVE),
+//       output_line(24, GPIOD_LINE_VALUE_INACTIVE));
+//   static_request<lines.size()> request("/dev/gpiochip0", "me", lines);
+//   request.set_values(lines.init_values());
+
+struct line_spec {
+    unsigned int offset;
+    gpiod_line_direction direction;
+    gpiod_line_bias bias;
+    gpiod_line_edge edge;
+    gpiod_line_drive drive;
+    unsigned long debounce_us;
+    gpiod_line_value init_value;    // outputs only
+};
+
+constexpr line_spec input_line(unsigned int offset,
+                               gpiod_line_bias bias = GPIOD_LINE_BIAS_PULL_UP,
+                               gpiod_line_edge edge = GPIOD_LINE_EDGE_NONE,
+                               unsigned long debounce_us = 0)
+{
+    return { offset, GPIOD_LINE_DIRECTION_INPUT, bias, edge,
+             GPIOD_LINE_DRIVE_PUSH_PULL, debounce_us, GPIOD_LINE_VALUE_INACTIVE };
+}
+
+constexpr line_spec output_line(unsigned int offset,
+                                gpiod_line_value init_value = GPIOD_LINE_VALUE_INACTIVE,
+                                gpiod_line_drive drive = GPIOD_LINE_DRIVE_PUSH_PULL)
+{
+    return { offset, GPIOD_LINE_DIRECTION_OUTPUT, GPIOD_LINE_BIAS_AS_IS,
+             GPIOD_LINE_EDGE_NONE, drive, 0, init_value };
+}
+
+template <size_t N>
+using line_values = std::array<gpiod_line_value, N>;
+
+template <size_t N>
+struct line_set {
+
+    std::array<line_spec, N> lines;
+
+    static constexpr size_t size() { return N; }
+
+    constexpr std::array<unsigned int, N> offsets() const
+    {
+        std::array<unsigned int, N> o { };
+        for (size_t i = 0; i < N; i++)
+            o[i] = lines[i].offset;
+        return o;
+    }
+
+    constexpr line_values<N> init_values() const
+    {
+        line_values<N> v { };
+        for (size_t i = 0; i < N; i++)
+            v[i] = lines[i].init_value;
+        return v;
+    }
+
+    // Index of offset in the set, or N if it isn't in it.
+    constexpr size_t index_of(unsigned int offset) const
+    {
+        for (size_t i = 0; i < N; i++)
+            if (lines[i].offset == offset)
+                return i;
+        return N;
+    }
+};
+
+template <typename... Specs>
+constexpr line_set<sizeof...(Specs)> make_line_set(Specs... specs)
+{
+    return { { { specs... } } };
+}
+
+// Table of all 2^N binary codes on N lines: entry c has line i active if
+// bit i of c is set (line 0 is the lsb). Built by the compiler.
+template <size_t N>
+constexpr std::array<line_values<N>, (size_t(1) << N)> binary_code_table()
+{
+    std::array<line_values<N>, (size_t(1) << N)> table { };
+    for (size_t c = 0; c < table.size(); c++)
+        for (size_t i = 0; i < N; i++)
+            table[c][i] = ((c >> i) & 1) ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE;
+    return table;
+}
+
+
+// Open the chip, request the lines, and close the chip again (the request
+// has its own fd). Asserts on failure, like the example programs.
+template <size_t N>
+gpiod_line_request *request_lines(const char *chip_path, const char *consumer,
+                                  const line_set<N> &set)
+{
+    const std::array<unsigned int, N> offsets = set.offsets();
+    const line_values<N> init_values = set.init_values();
+
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    // One settings object, reset and refilled for each line.
+    for (size_t i = 0; i < N; i++) {
+        const line_spec &l = set.lines[i];
+        gpiod_line_settings_reset(settings);
+        gpiod_line_settings_set_direction(settings, l.direction);
+        if (l.direction == GPIOD_LINE_DIRECTION_INPUT) {
+            gpiod_line_settings_set_bias(settings, l.bias);
+            gpiod_line_settings_set_edge_detection(settings, l.edge);
+            gpiod_line_settings_set_debounce_period_us(settings, l.debounce_us);
+            gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+        } else {
+            gpiod_line_settings_set_drive(settings, l.drive);
+        }
+        int r = gpiod_line_config_add_line_settings(line_config, &offsets[i], 1, settings);
+        assert(r == 0);
+    }
+
+    gpiod_line_settings_free(settings);
+
+    // Initial values only matter for outputs; inputs ignore theirs.
+    int r1 = gpiod_line_config_set_output_values(line_config, init_values.data(), N);
+    assert(r1 == 0);
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+    gpiod_request_config_set_consumer(request_config, consumer);
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    gpiod_line_config_free(line_config);
+    gpiod_chip_close(chip);
+
+    return request;
+}
+
+
+// A line request whose line count is part of its type, so values are
+// passed as fixed-size arrays. Released when it goes out of scope.
+template <size_t N>
+class static_request
+{
+public:
+
+    static_request(const char *chip_path, const char *consumer, const line_set<N> &set) :
+        _request(request_lines(chip_path, consumer, set))
+    {
+    }
+
+    ~static_request()
+    {
+        gpiod_line_request_release(_request);
+    }
+
+    static_request(const static_request &) = delete;
+    static_request &operator=(const static_request &) = delete;
+
+    int set_values(const line_values<N> &values)
+    {
+        return gpiod_line_request_set_values(_request, values.data());
+    }
+
+    int get_values(line_values<N> &values)
+    {
+        return gpiod_line_request_get_values(_request, values.data());
+    }
+
+    gpiod_line_request *get() { return _request; }
+
+private:
+
+    gpiod_line_request *_request;
+
+}; // class static_request
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// HDR-style histogram of uint64_t values (typically nanoseconds).
+//
+// Values below 2^sub_bits each get their own bucket. Above that, every
+// power of two is split into 2^sub_bits equal buckets, so any recorded
+// value is known to within 1 part in 2^sub_bits (about 3% with the
+// default of 5) across the whole 64-bit range. Storage is a fixed array
+// inside the object, and record() is a few shifts and an increment, so it
+// is fine to call on every event.
+
+template <int sub_bits = 5>
+class histogram
+{
+public:
+
+    histogram() { reset(); }
+
+    void reset()
+    {
+        memset(_counts, 0, sizeof(_counts));
+        _count = 0;
+        _min = UINT64_MAX;
+        _max = 0;
+        _sum = 0;
+    }
+
+    void record(uint64_t value)
+    {
+        _counts[index(value)]++;
+        _count++;
+        _sum += value;
+        if (value < _min)
+            _min = value;
+        if (value > _max)
+            _max = value;
+    }
+
+    // Add all of other's counts into this one.
+    void add(const histogram &other)
+    {
+        for (int i = 0; i < num_buckets; i++)
+            _counts[i] += other._counts[i];
+        _count += other._count;
+        _sum += other._sum;
+        if (other._min < _min)
+            _min = other._min;
+        if (other._max > _max)
+            _max = other._max;
+    }
+
+    uint64_t count() const { return _count; }
+    uint64_t min() const { return _count ? _min : 0; }
+    uint64_t max() const { return _max; }
+    double mean() const { return _count ? double(_sum) / _count : 0.0; }
+
+    // Value at or below which 'percent' of the recorded values fall. The
+    // top of the bucket is returned (clamped to max), so this errs high.
+    uint64_t percentile(double percent) const
+    {
+        if (_count == 0)
+            return 0;
+        uint64_t target = uint64_t(percent / 100.0 * _count + 0.5);
+        if (target < 1)
+            target = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < num_buckets; i++) {
+            seen += _counts[i];
+            if (seen >= target) {
+                uint64_t v = highest(i);
+                return v < _max ? v : _max;
+            }
+        }
+        return _max;
+    }
+
+private:
+
+    static const uint64_t sub_count = uint64_t(1) << sub_bits;
+    static const int num_buckets = (65 - sub_bits) * sub_count;
+
+    static int index(uint64_t value)
+    {
+        if (value < sub_count)
+            return value;
+        int shift = 63 - __builtin_clzll(value) - sub_bits;
+        return (shift + 1) * sub_count + ((value >> shift) - sub_count);
+    }
+
+    // largest value that goes in bucket i
+    static uint64_t highest(int i)
+    {
+        if (uint64_t(i) < sub_count)
+            return i;
+        int shift = i / sub_count - 1;
+        uint64_t mant = i % sub_count + sub_count;
+        return ((mant + 1) << shift) - 1;
+    }
+
+    uint64_t _counts[num_buckets];
+    uint64_t _count;
+    uint64_t _min;
+    uint64_t _max;
+    uint64_t _sum;
+
+}; // class histogram
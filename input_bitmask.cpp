@@ -0,0 +1,270 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <linux/gpio.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <gpiod.h>
+#include "line_bits.h"
+
+// Poll every free line of one or more chips and print the ones that
+// change, using packed bitmasks instead of per-line value arrays.
+//
+// input_simple reads two lines into an array of gpiod_line_value and
+// compares them one by one. That is fine for two lines, but the work (and
+// libgpiod's unpacking of the kernel's bitmask into that array) grows
+// with every line, even when nothing changed. Here:
+//
+// * Each chip's free lines are requested in groups of up to 64 (the
+//   kernel's limit per request). The values of a group are read with the
+//   kernel's GPIO_V2_LINE_GET_VALUES_IOCTL straight into one 64-bit word,
+//   which is the layout line_bits.h uses, so there is no unpacking.
+// * Old and new samples are compared a word at a time (XOR), and only
+//   the bits that differ are visited (see line_bits_changes).
+//
+// Lines are requested with direction "as is", so outputs stay outputs
+// (and are watched too); bias and everything else is left alone. Lines
+// already in use by someone else (kernel drivers included) are skipped.
+//
+// Usage: input_bitmask [-i poll_us] [chip ...]    (default /dev/gpiochip0)
+//
+// At exit, the average time per sample for reading and for finding
+// changes is printed.
+
+static const char *default_chip_path = "/dev/gpiochip0";
+
+static const int max_chips = 16;
+static const int max_groups = 256;  // 64 lines each
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+// Up to 64 lines of one chip, requested together; one word of samples.
+struct line_group {
+    int chip;                   // index into chip_paths
+    gpiod_line_request *request;
+    int fd;                     // request fd, for the values ioctl
+    int num_lines;
+    unsigned int offsets[line_bits_per_word];
+};
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void sleep_until(uint64_t t_ns)
+{
+    timespec ts;
+    ts.tv_sec = t_ns / 1000000000;
+    ts.tv_nsec = t_ns % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr); // EINTR is fine
+}
+
+
+static gpiod_line_request *request_group(gpiod_chip *chip, const unsigned int *offsets,
+                                         int num_lines)
+{
+    // Default settings are direction, bias, drive all "as is".
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r = gpiod_line_config_add_line_settings(line_config, offsets, num_lines, settings);
+    assert(r == 0);
+
+    gpiod_line_settings_free(settings);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_bitmask");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+
+    gpiod_request_config_free(request_config);
+    gpiod_line_config_free(line_config);
+
+    return request;
+}
+
+
+// Read one group's values into a word (bit i is offsets[i]).
+static uint64_t read_group(const line_group &g)
+{
+    gpio_v2_line_values values;
+    values.bits = 0;
+    values.mask = line_bits_mask(g.num_lines);
+    int r = ioctl(g.fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values);
+    assert(r == 0);
+    return values.bits;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    long poll_us = 1000;
+    const char *chip_paths[max_chips];
+    int num_chips = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            poll_us = strtol(argv[++i], nullptr, 0);
+        } else if (argv[i][0] != '-' && num_chips < max_chips) {
+            chip_paths[num_chips++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-i poll_us] [chip ...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (num_chips == 0)
+        chip_paths[num_chips++] = default_chip_path;
+
+    if (poll_us <= 0) {
+        fprintf(stderr, "%s: poll_us must be positive\n", argv[0]);
+        return 1;
+    }
+
+    static line_group groups[max_groups];
+    int num_groups = 0;
+    int total_lines = 0;
+
+    gpiod_chip *chips[max_chips];
+
+    for (int c = 0; c < num_chips; c++) {
+
+        chips[c] = gpiod_chip_open(chip_paths[c]);
+        if (chips[c] == nullptr) {
+            fprintf(stderr, "%s: can't open %s: %s\n", argv[0], chip_paths[c], strerror(errno));
+            return 1;
+        }
+
+        gpiod_chip_info *info = gpiod_chip_get_info(chips[c]);
+        assert(info != nullptr);
+        unsigned int num_lines = gpiod_chip_info_get_num_lines(info);
+        gpiod_chip_info_free(info);
+
+        // Collect the free lines, 64 to a group.
+        int skipped = 0;
+        line_group *g = nullptr;
+        for (unsigned int offset = 0; offset < num_lines; offset++) {
+            gpiod_line_info *line_info = gpiod_chip_get_line_info(chips[c], offset);
+            assert(line_info != nullptr);
+            bool used = gpiod_line_info_is_used(line_info);
+            gpiod_line_info_free(line_info);
+            if (used) {
+                skipped++;
+                continue;
+            }
+            if (g == nullptr || g->num_lines == line_bits_per_word) {
+                if (num_groups == max_groups) {
+                    fprintf(stderr, "%s: too many lines\n", argv[0]);
+                    return 1;
+                }
+                g = &groups[num_groups++];
+                g->chip = c;
+                g->num_lines = 0;
+            }
+            g->offsets[g->num_lines++] = offset;
+        }
+
+        int chip_lines = 0;
+        for (int n = 0; n < num_groups; n++) {
+            line_group &gr = groups[n];
+            if (gr.chip != c)
+                continue;
+            gr.request = request_group(chips[c], gr.offsets, gr.num_lines);
+            if (gr.request == nullptr) {
+                fprintf(stderr, "%s: can't request lines on %s: %s\n", argv[0], chip_paths[c],
+                        strerror(errno));
+                return 1;
+            }
+            gr.fd = gpiod_line_request_get_fd(gr.request);
+            chip_lines += gr.num_lines;
+        }
+
+        printf("%s: %d lines (%d in use, skipped)\n", chip_paths[c], chip_lines, skipped);
+        total_lines += chip_lines;
+    }
+
+    printf("watching %d lines in %d words, every %ld usec\n", total_lines, num_groups, poll_us);
+
+    // One word per group.
+    static uint64_t old_bits[max_groups];
+    static uint64_t new_bits[max_groups];
+
+    for (int n = 0; n < num_groups; n++)
+        old_bits[n] = read_group(groups[n]);
+
+    uint64_t samples = 0, changes = 0;
+    uint64_t read_ns = 0, detect_ns = 0;
+
+    uint64_t next_ns = now_ns() + poll_us * 1000;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        sleep_until(next_ns);
+        next_ns += poll_us * 1000;
+
+        uint64_t t0_ns = now_ns();
+
+        for (int n = 0; n < num_groups; n++)
+            new_bits[n] = read_group(groups[n]);
+
+        uint64_t t1_ns = now_ns();
+
+        changes += line_bits_changes(old_bits, new_bits, num_groups, [&](int bit, int value) {
+            const line_group &g = groups[bit / line_bits_per_word];
+            printf("%s:%u = %d\n", chip_paths[g.chip],
+                   g.offsets[bit % line_bits_per_word], value);
+        });
+
+        uint64_t t2_ns = now_ns();
+
+        memcpy(old_bits, new_bits, num_groups * sizeof(uint64_t));
+
+        samples++;
+        read_ns += t1_ns - t0_ns;
+        detect_ns += t2_ns - t1_ns; // includes printing, when there are changes
+
+        // If the loop fell behind, don't try to catch up.
+        if (next_ns < t2_ns)
+            next_ns = t2_ns + poll_us * 1000;
+
+    } // while
+
+    if (samples > 0)
+        printf("%" PRIu64 " samples, %" PRIu64 " changes; per sample: read %.0f nsec,"
+               " detect %.0f nsec\n", samples, changes, double(read_ns) / samples,
+               double(detect_ns) / samples);
+
+    for (int n = 0; n < num_groups; n++)
+        gpiod_line_request_release(groups[n].request);
+
+    for (int c = 0; c < num_chips; c++)
+        gpiod_chip_close(chips[c]);
+
+    return 0;
+
+} // main
@@ -0,0 +1,323 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <linux/gpio.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <gpiod.h>
+#include "line_bits.h"
+
+// Logic analyzer style capture: sample inputs continuously into a ring,
+// and when a trigger condition is seen, print the samples from before
+// and after it.
+//
+// All lines are read with one GPIO_V2_LINE_GET_VALUES_IOCTL, which gives
+// the values packed one bit per line in a word (see line_bits.h); the
+// word and a timestamp go into the ring. The ring is allocated and
+// touched before sampling starts and the loop does nothing but read,
+// store and compare, so it runs as fast as the ioctl allows (and keeps a
+// CPU busy doing it).
+//
+// The trigger is a pattern with one character per line, in the order
+// the lines were given:
+//
+//   x  don't care      0  low         1  high
+//   r  rising edge     f  falling     c  either edge
+//
+// It fires on the first sample where every line matches (for edges, when
+// compared with the previous sample), and not again until it has stopped
+// matching. Level-only patterns therefore trigger on entering the state.
+// With no pattern, any change on any line triggers.
+//
+// Usage: input_capture [-t pattern] [-b before] [-a after] [-n captures]
+//                      [chip:offset[,offset...]]
+//
+//   defaults: -b 1000, -a 1000, -n 1 (0 = forever), /dev/gpiochip0:23,24
+//
+// Each capture prints one row per sample: time relative to the trigger
+// (usec) and the value of each line. Sampling pauses while printing.
+
+static const char *default_lines = "/dev/gpiochip0:23,24";
+
+static const int max_lines = line_bits_per_word;
+
+static const unsigned long debounce_us = 0; // no debounce: see every sample
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static bool parse_lines(const char *arg, char *chip_path, size_t chip_len,
+                        unsigned int *offsets, int &num_offsets)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || size_t(colon - arg) >= chip_len)
+        return false;
+    memcpy(chip_path, arg, colon - arg);
+    chip_path[colon - arg] = '\0';
+    num_offsets = 0;
+    const char *p = colon + 1;
+    while (*p != '\0' && num_offsets < max_lines) {
+        char *end;
+        offsets[num_offsets++] = strtoul(p, &end, 0);
+        if (end == p)
+            return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return num_offsets > 0 && *p == '\0';
+}
+
+
+// Trigger pattern as bit masks over the sample word.
+struct trigger {
+    uint64_t level_mask;    // lines that must be at a level...
+    uint64_t level_bits;    // ...and the level
+    uint64_t rise_mask;     // lines that must have just gone 0 -> 1
+    uint64_t fall_mask;     // lines that must have just gone 1 -> 0
+    uint64_t change_mask;   // lines that must have just changed
+
+    bool match(uint64_t old_bits, uint64_t new_bits) const
+    {
+        uint64_t rose = ~old_bits & new_bits;
+        uint64_t fell = old_bits & ~new_bits;
+        return ((new_bits ^ level_bits) & level_mask) == 0 &&
+               (rise_mask & ~rose) == 0 &&
+               (fall_mask & ~fell) == 0 &&
+               (change_mask & ~(rose | fell)) == 0;
+    }
+};
+
+
+static bool parse_trigger(const char *pattern, int num_lines, trigger &t)
+{
+    memset(&t, 0, sizeof(t));
+    if (int(strlen(pattern)) != num_lines)
+        return false;
+    for (int i = 0; i < num_lines; i++) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (pattern[i]) {
+        case 'x': break;
+        case '0': t.level_mask |= bit; break;
+        case '1': t.level_mask |= bit; t.level_bits |= bit; break;
+        case 'r': t.rise_mask |= bit; break;
+        case 'f': t.fall_mask |= bit; break;
+        case 'c': t.change_mask |= bit; break;
+        default: return false;
+        }
+    }
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    const char *pattern = nullptr;
+    long before = 1000;
+    long after = 1000;
+    long captures = 1;
+    const char *lines_arg = default_lines;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            pattern = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            before = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            after = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            captures = strtol(argv[++i], nullptr, 0);
+        } else if (argv[i][0] != '-') {
+            lines_arg = argv[i];
+        } else {
+            argc = 0; // force usage message
+        }
+    }
+
+    char chip_path[64];
+    unsigned int offsets[max_lines];
+    int num_lines = 0;
+
+    if (argc == 0 || before < 0 || after < 0 || captures < 0 ||
+        !parse_lines(lines_arg, chip_path, sizeof(chip_path), offsets, num_lines)) {
+        fprintf(stderr, "usage: %s [-t pattern] [-b before] [-a after] [-n captures]"
+                " [chip:offset[,offset...]]\n", argv[0]);
+        return 1;
+    }
+
+    // With no pattern the trigger is any line changing, which a pattern
+    // can't say ("cc" means both lines change in the same sample).
+    trigger trig;
+    bool any_change = pattern == nullptr;
+    if (!any_change && !parse_trigger(pattern, num_lines, trig)) {
+        fprintf(stderr, "%s: pattern needs one of x01rfc per line (%d lines)\n", argv[0],
+                num_lines);
+        return 1;
+    }
+
+    // Ring: a power of two, big enough for before + trigger + after.
+    size_t ring_size = 1;
+    while (ring_size < size_t(before + after + 1))
+        ring_size *= 2;
+    const size_t ring_mask = ring_size - 1;
+
+    uint64_t *ring_bits = new uint64_t[ring_size];
+    uint64_t *ring_ns = new uint64_t[ring_size];
+    // touch every page now so the loop never faults
+    memset(ring_bits, 0, ring_size * sizeof(uint64_t));
+    memset(ring_ns, 0, ring_size * sizeof(uint64_t));
+
+    // Line settings etc. as in input_simple, but for any list of lines.
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_NONE);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, num_lines, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    if (chip == nullptr) {
+        fprintf(stderr, "%s: can't open %s: %s\n", argv[0], chip_path, strerror(errno));
+        return 1;
+    }
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_capture");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    // Values are read with the ioctl directly (packed, no unpacking into
+    // gpiod_line_value); bit i is offsets[i].
+    gpio_v2_line_values values;
+    values.mask = line_bits_mask(num_lines);
+    const int fd = gpiod_line_request_get_fd(request);
+
+    printf("%d lines, %ld before, %ld after, ring %zu samples\n", num_lines, before, after,
+           ring_size);
+    fflush(stdout);
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    long captured = 0;
+
+    while (!quitting && (captures == 0 || captured < captures)) {
+
+        // Arm: fill 'before' samples first so the pre-trigger part of a
+        // capture is always complete, then look for the trigger.
+        uint64_t pos = 0;           // samples taken since arming
+        uint64_t trigger_pos = 0;
+        bool triggered = false;
+        bool complete = false;
+        bool was_match = true;      // don't fire on a condition already true
+        uint64_t old_bits = 0;
+
+        while (!quitting) {
+
+            int r2 = ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values);
+            assert(r2 == 0);
+            uint64_t t_ns = now_ns();
+
+            uint64_t new_bits = values.bits;
+            ring_bits[pos & ring_mask] = new_bits;
+            ring_ns[pos & ring_mask] = t_ns;
+
+            if (triggered) {
+                if (pos == trigger_pos + after) {
+                    complete = true;
+                    break;
+                }
+            } else if (pos > 0) {
+                bool match = any_change ? new_bits != old_bits : trig.match(old_bits, new_bits);
+                if (match && !was_match && pos >= uint64_t(before)) {
+                    triggered = true;
+                    trigger_pos = pos;
+                    if (after == 0) {
+                        complete = true;
+                        break;
+                    }
+                }
+                was_match = match;
+            }
+
+            old_bits = new_bits;
+            pos++;
+
+        } // while
+
+        if (!complete)
+            break; // ctrl-c before the capture was done
+
+        // Dump. The time of each sample is relative to the trigger.
+        uint64_t trigger_ns = ring_ns[trigger_pos & ring_mask];
+        uint64_t first = trigger_pos - before;
+        uint64_t last = trigger_pos + after;
+        printf("capture %ld: %.1f nsec/sample\n", captured + 1,
+               double(ring_ns[last & ring_mask] - ring_ns[first & ring_mask]) /
+               (last - first ? last - first : 1));
+        printf("%12s", "usec");
+        for (int i = 0; i < num_lines; i++)
+            printf(" %4u", offsets[i]);
+        printf("\n");
+        for (uint64_t p = first; p <= last; p++) {
+            int64_t dt_ns = int64_t(ring_ns[p & ring_mask] - trigger_ns);
+            printf("%12.3f", dt_ns / 1e3);
+            for (int i = 0; i < num_lines; i++)
+                printf(" %4d", line_bits_get(&ring_bits[p & ring_mask], i));
+            printf("%s\n", p == trigger_pos ? "  <- trigger" : "");
+        }
+        printf("\n");
+        fflush(stdout);
+
+        captured++;
+
+    } // while
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    delete[] ring_bits;
+    delete[] ring_ns;
+
+    return 0;
+
+} // main
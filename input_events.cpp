@@ -5,8 +5,21 @@
 #include <signal.h> // ctrl-c handler
 #include <stdio.h>
 #include <gpiod.h>
+#include "rt_profile.h"
+#include "seqno_check.h"
 
 // This configures two pins as inputs then print messages as they change.
+//
+// Sequence numbers are checked as events arrive. A gap means the kernel's
+// event buffer overflowed and events were lost; when that happens the
+// lines are read directly so the printed state is correct again, and lost
+// events are counted per line and reported at exit.
+//
+// Usage: input_events [-r] [-p priority] [-c cpu]
+//
+// Any of the options turns on the real-time profile (see rt_profile.h) for
+// the event loop; page faults and context switches are reported at exit
+// either way.
 
 static const char *chip_path = "/dev/gpiochip0";
 
@@ -30,6 +43,16 @@ static void ctrl_c_handler(int notused)
 int main(int argc, char *argv[])
 {
 
+    rt_options rt;
+    rt_options_init(rt);
+
+    for (int i = 1; i < argc; i++) {
+        if (!rt_options_parse(i, argc, argv, rt)) {
+            fprintf(stderr, "usage: %s %s\n", argv[0], rt_options_usage);
+            return 1;
+        }
+    }
+
     // Allocate event buffer. An event buffer is a control structure with
     // pointers to two buffers: one used to read raw event data (array of
     // struct gpio_v2_line_event) from the request fd, and another used to
@@ -139,6 +162,16 @@ int main(int argc, char *argv[])
 
     uint64_t last_ns = 0;
 
+    // Gap detection; line index is position in offsets[].
+    seqno_check<gpio_pin_cnt> seqnos;
+    uint64_t gaps = 0;
+
+    // Everything the loop uses is allocated by now, so this locks it in.
+    if (rt.enabled)
+        rt_profile_apply(rt.priority, rt.cpu);
+
+    rt_usage usage = rt_usage_now();
+
     // ctrl-c sets 'quitting' flag
     signal(SIGINT, ctrl_c_handler);
 
@@ -169,6 +202,22 @@ int main(int argc, char *argv[])
             unsigned int pin_val =
                 gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0;
             uint64_t timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+
+            int line = pin_num == offsets[0] ? 0 : 1;
+            uint64_t missed = seqnos.check(global_seqno, line, line_seqno);
+            if (missed != 0) {
+                // Events were lost before this one, so the edges printed
+                // so far don't tell what state the lines are in. Read them.
+                gaps++;
+                gpiod_line_value values[gpio_pin_cnt];
+                int r3 = gpiod_line_request_get_values(request, values);
+                assert(r3 == 0);
+                printf("gap: %" PRIu64 " events lost; now pin %u = %d, pin %u = %d\n",
+                       missed, offsets[0], values[0] == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0,
+                       offsets[1], values[1] == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0);
+                last_ns = 0;
+            }
+
             printf("%lu:%lu pin %u = %u @ %" PRIu64, global_seqno, line_seqno,
                     pin_num, pin_val, timestamp_ns);
             if (last_ns != 0)
@@ -181,6 +230,13 @@ int main(int argc, char *argv[])
 
     } // while
 
+    printf("%" PRIu64 " gaps, %" PRIu64 " events lost", gaps, seqnos.global_missed);
+    for (int line = 0; line < gpio_pin_cnt; line++)
+        printf(", pin %u: %" PRIu64, offsets[line], seqnos.line_missed[line]);
+    printf("\n");
+
+    rt_usage_print(usage);
+
     gpiod_line_request_release(request);
     request = nullptr;
 
@@ -0,0 +1,229 @@
+#include <cassert>
+#include <cstdint>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <gpiod.h>
+
+// Same inputs as input_events, but the event buffer sizes adapt to the
+// bursts actually seen.
+//
+// There are two buffers. The userspace one (gpiod_edge_event_buffer) is
+// how many events one read call can return; the kernel one (set with
+// gpiod_request_config_set_event_buffer_size) is how many events the
+// kernel holds before it starts throwing them away.
+//
+// * If a read fills the userspace buffer, there were (probably) more
+//   events waiting, so the userspace buffer is doubled. That is cheap (no
+//   kernel calls) and cuts the number of reads per burst.
+// * Everything one read returns was in the kernel buffer at the same
+//   time, so a single read's count is a lower bound on how full the
+//   kernel buffer got. (Adding up back-to-back reads is not: more events
+//   arrive between them.) If one read returns 3/4 of the kernel buffer,
+//   or the global seqno shows events were already lost, the kernel buffer
+//   is doubled. The event buffer size is fixed
+//   when the lines are requested, so this means releasing and requesting
+//   the lines again; edges in that window are lost, which is why growing
+//   is done early rather than waiting for overflow.
+//
+// Events are counted, not printed. Sizes are printed when they change,
+// and statistics once a second and at exit.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+// Userspace buffer limits.
+static const size_t user_events_min = 32;
+static const size_t user_events_max = 1024;
+
+// Kernel buffer limits. The kernel uses 16 events per line if asked for
+// zero, and won't go over 16 * GPIO_V2_LINES_MAX (1024).
+static const size_t kernel_events_min = 16 * gpio_pin_cnt;
+static const size_t kernel_events_max = 1024;
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+// Request the lines with the given kernel event buffer size.
+static gpiod_line_request *request_lines(gpiod_chip *chip,
+                                         gpiod_line_config *line_config,
+                                         size_t kernel_events)
+{
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_adaptive");
+    gpiod_request_config_set_event_buffer_size(request_config, kernel_events);
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+
+    return request;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    // Line settings and line config are the same as in input_events.
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    // line_config is kept (not freed here) since the lines may be
+    // requested again with a bigger kernel buffer.
+    size_t kernel_events = kernel_events_min;
+    gpiod_line_request *request = request_lines(chip, line_config, kernel_events);
+
+    size_t user_events = user_events_min;
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(user_events);
+    assert(events != nullptr);
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+    printf("buffers: user %zu kernel %zu events\n", user_events, kernel_events);
+
+    // statistics
+    uint64_t reads = 0;             // read calls
+    uint64_t total_events = 0;      // events returned by all reads
+    uint64_t full_reads = 0;        // reads that filled the user buffer
+    uint64_t lost_events = 0;       // from global seqno gaps
+    uint64_t max_read = 0;          // most events returned by one read
+    uint64_t regrows = 0;           // times the lines were re-requested
+
+    unsigned long last_seqno = 0;   // last global seqno seen, 0 for none
+
+    uint64_t stats_reads = 0;       // reads at last stats print
+    uint64_t stats_events = 0;
+    uint64_t stats_ns = 0;          // event timestamp of last stats print
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        int r2 = gpiod_line_request_wait_edge_events(request, -1);
+        if (r2 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r2 == 1);
+
+        int num_events = gpiod_line_request_read_edge_events(request, events, user_events);
+        assert(num_events > 0);
+
+        reads++;
+        total_events += num_events;
+        if (uint64_t(num_events) > max_read)
+            max_read = num_events;
+
+        bool lost = false;
+        uint64_t last_ns = 0;
+        for (int i = 0; i < num_events; i++) {
+            gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+            unsigned long seqno = gpiod_edge_event_get_global_seqno(event);
+            if (last_seqno != 0 && seqno != last_seqno + 1) {
+                lost_events += seqno - last_seqno - 1;
+                lost = true;
+            }
+            last_seqno = seqno;
+            last_ns = gpiod_edge_event_get_timestamp_ns(event);
+        }
+
+        bool full = size_t(num_events) == user_events;
+
+        if (full) {
+            full_reads++;
+            if (user_events < user_events_max) {
+                gpiod_edge_event_buffer_free(events);
+                user_events *= 2;
+                events = gpiod_edge_event_buffer_new(user_events);
+                assert(events != nullptr);
+                printf("buffers: user %zu kernel %zu events (user buffer filled)\n",
+                       user_events, kernel_events);
+            }
+        }
+
+        bool near_full = size_t(num_events) >= kernel_events * 3 / 4;
+
+        if ((lost || near_full) && kernel_events < kernel_events_max) {
+            kernel_events *= 2;
+            gpiod_line_request_release(request);
+            request = request_lines(chip, line_config, kernel_events);
+            regrows++;
+            // The new request's seqnos start over.
+            last_seqno = 0;
+            printf("buffers: user %zu kernel %zu events (%s)\n", user_events,
+                   kernel_events, lost ? "events lost" : "read near capacity");
+        }
+
+        // once a second (by event time)
+        if (last_ns - stats_ns >= 1000000000) {
+            if (stats_ns != 0) {
+                uint64_t r = reads - stats_reads;
+                uint64_t e = total_events - stats_events;
+                printf("%" PRIu64 " events in %" PRIu64 " reads (%.2f events/read)\n",
+                       e, r, r ? double(e) / r : 0.0);
+            }
+            stats_ns = last_ns;
+            stats_reads = reads;
+            stats_events = total_events;
+        }
+
+    } // while
+
+    printf("buffers: user %zu kernel %zu events\n", user_events, kernel_events);
+    printf("%" PRIu64 " events, %" PRIu64 " reads (%.2f events/read), %" PRIu64
+           " full reads\n", total_events, reads, reads ? double(total_events) / reads : 0.0,
+           full_reads);
+    printf("max read %" PRIu64 " events, %" PRIu64 " lost, %" PRIu64 " re-requests\n",
+           max_read, lost_events, regrows);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
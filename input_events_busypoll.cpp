@@ -0,0 +1,280 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <gpiod.h>
+#include "histogram.h"
+#include "rt_profile.h"
+
+// Same inputs as input_events, but waits by busy-polling for a while
+// before sleeping in the kernel.
+//
+// A blocking wait costs a wakeup: the interrupt thread makes the event
+// available, the scheduler has to notice this process is runnable, and
+// (if the CPU was idle) the CPU has to come out of its idle state. That
+// is often tens of microseconds. Spinning avoids all of it at the cost of
+// a CPU doing nothing useful.
+//
+// Here the request fd is made non-blocking, and after each batch of
+// events the loop keeps trying to read (each try is one read() that
+// fails with EAGAIN if there's nothing) for up to the spin budget. If
+// nothing comes it falls back to a blocking wait. Events that arrive soon
+// after the previous ones (bursts, fast control loops) are picked up by
+// the spin; isolated ones still cost nothing while idle.
+//
+// Usage: input_events_busypoll [-b budget_us] [-r] [-p priority] [-c cpu]
+//
+//   budget_us  0 never spins (same as input_events), -1 spins forever,
+//              default 1000
+//
+// Edge-to-userspace latency is measured as in input_events_latency,
+// separately for events found while spinning and events that needed the
+// blocking wait, along with the CPU time used, every few seconds and at
+// exit. Spinning forever at a real-time priority takes the CPU away from
+// everything else of lower priority; use -c to keep that to one core.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+static const uint64_t report_ns = 5000000000ULL; // report interval
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+// User + system CPU time used by the process.
+static uint64_t cpu_ns()
+{
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t(ru.ru_utime.tv_sec) + ru.ru_stime.tv_sec) * 1000000000 +
+           (uint64_t(ru.ru_utime.tv_usec) + ru.ru_stime.tv_usec) * 1000;
+}
+
+
+static void print_latency(const char *label, const histogram<> &h)
+{
+    if (h.count() == 0) {
+        printf("  %-5s no events\n", label);
+        return;
+    }
+    printf("  %-5s %7" PRIu64 " events, usec p50 %.1f p99 %.1f max %.1f\n", label,
+           h.count(), h.percentile(50) / 1e3, h.percentile(99) / 1e3, h.max() / 1e3);
+}
+
+
+static void print_report(const char *label, const histogram<> &spin, const histogram<> &block,
+                         uint64_t wall_ns, uint64_t used_ns, uint64_t spins)
+{
+    printf("%s: cpu %.1f%% (%.3f of %.3f sec), %" PRIu64 " empty reads\n", label,
+           wall_ns ? 100.0 * used_ns / wall_ns : 0.0, used_ns / 1e9, wall_ns / 1e9, spins);
+    print_latency("spin", spin);
+    print_latency("block", block);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    long budget_us = 1000;
+    rt_options rt;
+    rt_options_init(rt);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            budget_us = strtol(argv[++i], nullptr, 0);
+        } else if (!rt_options_parse(i, argc, argv, rt)) {
+            fprintf(stderr, "usage: %s [-b budget_us] %s\n", argv[0], rt_options_usage);
+            return 1;
+        }
+    }
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    // latency is computed against CLOCK_MONOTONIC, so this must match
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_busypoll");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    // With O_NONBLOCK, gpiod_line_request_read_edge_events returns -1 with
+    // errno EAGAIN instead of sleeping when there are no events. The
+    // blocking wait (poll) is not affected.
+    int fd = gpiod_line_request_get_fd(request);
+    int r2 = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    assert(r2 == 0);
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+    if (budget_us < 0)
+        printf("spin budget = forever\n");
+    else
+        printf("spin budget = %ld usec\n", budget_us);
+
+    static histogram<> spin_interval, block_interval;  // since last report
+    static histogram<> spin_total, block_total;        // whole run
+    uint64_t spins_interval = 0, spins_total = 0;
+
+    if (rt.enabled)
+        rt_profile_apply(rt.priority, rt.cpu);
+
+    uint64_t start_ns = now_ns();
+    uint64_t start_cpu_ns = cpu_ns();
+    uint64_t report_start_ns = start_ns;
+    uint64_t report_cpu_ns = start_cpu_ns;
+    uint64_t next_report_ns = start_ns + report_ns;
+
+    // Spinning stops at this time; 0 means go straight to the blocking
+    // wait. Starts at 0 since there's been no event yet.
+    uint64_t spin_until_ns = 0;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        bool spinning = budget_us < 0 || spin_until_ns != 0;
+
+        int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+
+        if (num_events < 0) {
+            assert(errno == EAGAIN);
+
+            uint64_t t_ns = now_ns();
+
+            if (spinning && (budget_us < 0 || t_ns < spin_until_ns) && t_ns < next_report_ns) {
+                spins_interval++;
+                continue;
+            }
+
+            // Budget used up (or report due): sleep until an event or the
+            // next report.
+            spin_until_ns = 0;
+
+            if (t_ns < next_report_ns) {
+                int r3 = gpiod_line_request_wait_edge_events(request, next_report_ns - t_ns);
+                if (r3 < 0 && errno == EINTR)
+                    break; // ctrl-c
+                assert(r3 >= 0);
+                if (r3 == 1)
+                    continue; // read at the top, counted as a blocking wait
+            }
+
+        } else {
+            assert(num_events > 0);
+
+            // One clock read per read call, as in input_events_latency.
+            uint64_t read_ns = now_ns();
+            histogram<> &h = spinning ? spin_interval : block_interval;
+
+            for (int i = 0; i < num_events; i++) {
+                gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+                uint64_t timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+                h.record(read_ns > timestamp_ns ? read_ns - timestamp_ns : 0);
+            }
+
+            // Another event may be right behind this one: spin for it.
+            if (budget_us > 0)
+                spin_until_ns = read_ns + uint64_t(budget_us) * 1000;
+        }
+
+        uint64_t t_ns = now_ns();
+        if (t_ns >= next_report_ns) {
+            uint64_t c_ns = cpu_ns();
+            print_report("last", spin_interval, block_interval, t_ns - report_start_ns,
+                         c_ns - report_cpu_ns, spins_interval);
+            spin_total.add(spin_interval);
+            block_total.add(block_interval);
+            spins_total += spins_interval;
+            spin_interval.reset();
+            block_interval.reset();
+            spins_interval = 0;
+            report_start_ns = t_ns;
+            report_cpu_ns = c_ns;
+            next_report_ns += report_ns;
+        }
+
+    } // while
+
+    spin_total.add(spin_interval);
+    block_total.add(block_interval);
+    spins_total += spins_interval;
+    print_report("total", spin_total, block_total, now_ns() - start_ns,
+                 cpu_ns() - start_cpu_ns, spins_total);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
@@ -0,0 +1,184 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "capture.h"
+
+// Same inputs as input_events, but instead of printing each event it
+// appends a 16-byte binary record to a capture file (see capture.h). No
+// text formatting is done while capturing; use capture_read to look at
+// the file afterwards.
+//
+// Usage: input_events_capture <file> [debounce_us]
+//
+// Capture with debounce_us 0 to record raw bounce, e.g. for debounce_bench.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+static const unsigned long default_debounce_us = 1000; // debounce time
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t clock_ns(clockid_t clk)
+{
+    timespec ts;
+    clock_gettime(clk, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "usage: %s <capture file> [debounce_us]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned long debounce_us =
+        argc == 3 ? strtoul(argv[2], nullptr, 0) : default_debounce_us;
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_capture");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    // Create the capture file and describe what is in it.
+    capture_writer capture;
+    if (!capture.open(argv[1])) {
+        fprintf(stderr, "%s: can't create %s: %s\n", argv[0], argv[1], strerror(errno));
+        return 1;
+    }
+
+    capture_header *hdr = capture.header();
+    strncpy(hdr->chip_path, chip_path, sizeof(hdr->chip_path) - 1);
+    gpiod_chip_info *chip_info = gpiod_chip_get_info(chip);
+    assert(chip_info != nullptr);
+    strncpy(hdr->chip_name, gpiod_chip_info_get_name(chip_info), sizeof(hdr->chip_name) - 1);
+    strncpy(hdr->chip_label, gpiod_chip_info_get_label(chip_info), sizeof(hdr->chip_label) - 1);
+    hdr->chip_num_lines = gpiod_chip_info_get_num_lines(chip_info);
+    gpiod_chip_info_free(chip_info);
+    chip_info = nullptr;
+    hdr->num_offsets = gpio_pin_cnt;
+    for (int i = 0; i < gpio_pin_cnt; i++)
+        hdr->offsets[i] = offsets[i];
+    hdr->debounce_us = debounce_us;
+    hdr->event_clock = GPIOD_LINE_CLOCK_MONOTONIC;
+    hdr->start_realtime_ns = clock_ns(CLOCK_REALTIME);
+    hdr->start_monotonic_ns = clock_ns(CLOCK_MONOTONIC);
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+    printf("capturing to %s\n", argv[1]);
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        int r2 = gpiod_line_request_wait_edge_events(request, -1);
+        if (r2 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r2 == 1);
+
+        int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+        assert(num_events > 0);
+
+        // Fill in records directly in the mapped file.
+        for (int i = 0; i < num_events; i++) {
+            gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+            capture_record *rec = capture.next();
+            if (rec == nullptr) {
+                fprintf(stderr, "%s: can't grow %s\n", argv[0], argv[1]);
+                quitting = true;
+                break;
+            }
+            unsigned int offset = gpiod_edge_event_get_line_offset(event);
+            uint8_t line_index = 0;
+            while (line_index < gpio_pin_cnt - 1 && offsets[line_index] != offset)
+                line_index++;
+            rec->timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+            rec->global_seqno = gpiod_edge_event_get_global_seqno(event);
+            rec->line_seqno = gpiod_edge_event_get_line_seqno(event);
+            rec->line_index = line_index;
+            rec->rising =
+                gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0;
+            capture.commit();
+        }
+
+    } // while
+
+    printf("%" PRIu64 " events captured\n", capture.count());
+
+    capture.close();
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
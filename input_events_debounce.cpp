@@ -0,0 +1,188 @@
+#include <cassert>
+#include <cstdint>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "debounce.h"
+
+// Same inputs as input_events, but debounced in userspace instead of by
+// the kernel (see debounce.h). The lines are requested with no kernel
+// debounce, every raw edge is read, and each line has its own algorithm
+// and period.
+//
+// Prints each debounced edge with the latency the debounce added, and the
+// raw edge count so the bounce can be seen. debounce_bench compares the
+// algorithms on recorded streams, and with kernel debounce on a loopback.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 64;   // max events to buffer
+
+// Per-line debounce, same order as offsets[] in main.
+static const struct {
+    debouncer::algorithm algo;
+    unsigned long period_us;
+} line_debounce[gpio_pin_cnt] = {
+    { debouncer::lockout, 1000 },   // 'a': pass first edge at once
+    { debouncer::stable,  1000 },   // 'b': same as kernel debounce
+};
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void print_output(unsigned int pin_num, const debouncer::output &out, uint64_t raw_edges)
+{
+    printf("pin %u = %u @ %" PRIu64 " (+%.1f us debounce, %" PRIu64 " raw edges)\n",
+           pin_num, out.level ? 1 : 0, out.decided_ns,
+           (out.decided_ns - out.source_ns) / 1e3, raw_edges);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Same as input_events except no kernel debounce.
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, 0);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_debounce");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    // Start each debouncer at the line's current level.
+    gpiod_line_value values[gpio_pin_cnt];
+    int r2 = gpiod_line_request_get_values(request, values);
+    assert(r2 == 0);
+
+    debouncer deb[gpio_pin_cnt];
+    uint64_t raw_edges[gpio_pin_cnt] = { 0 };
+    uint64_t start_ns = now_ns();
+    for (int line = 0; line < gpio_pin_cnt; line++) {
+        deb[line].init(line_debounce[line].algo, line_debounce[line].period_us * 1000,
+                       values[line] == GPIOD_LINE_VALUE_ACTIVE, start_ns);
+        printf("pin %u: %s %lu usec\n", offsets[line],
+               line_debounce[line].algo == debouncer::lockout ? "lockout" :
+               line_debounce[line].algo == debouncer::integrator ? "integrator" : "stable",
+               line_debounce[line].period_us);
+    }
+
+    debouncer::output out;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        // Sleep until the next event or the earliest pending debounce
+        // deadline, whichever comes first.
+        uint64_t deadline_ns = UINT64_MAX;
+        for (int line = 0; line < gpio_pin_cnt; line++)
+            if (deb[line].deadline() < deadline_ns)
+                deadline_ns = deb[line].deadline();
+        int64_t timeout_ns = -1;
+        if (deadline_ns != UINT64_MAX) {
+            uint64_t now = now_ns();
+            timeout_ns = deadline_ns > now ? deadline_ns - now : 0;
+        }
+
+        int r3 = gpiod_line_request_wait_edge_events(request, timeout_ns);
+        if (r3 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r3 >= 0);
+
+        if (r3 == 1) {
+            int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+            assert(num_events > 0);
+
+            for (int i = 0; i < num_events; i++) {
+                gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+                unsigned int pin_num = gpiod_edge_event_get_line_offset(event);
+                bool level = gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE;
+                uint64_t timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+                int line = 0;
+                while (line < gpio_pin_cnt - 1 && offsets[line] != pin_num)
+                    line++;
+                raw_edges[line]++;
+                if (deb[line].expire(timestamp_ns, out))
+                    print_output(pin_num, out, raw_edges[line]);
+                if (deb[line].edge(level, timestamp_ns, out))
+                    print_output(pin_num, out, raw_edges[line]);
+            }
+        }
+
+        uint64_t now = now_ns();
+        for (int line = 0; line < gpio_pin_cnt; line++)
+            if (deb[line].expire(now, out))
+                print_output(offsets[line], out, raw_edges[line]);
+
+    } // while
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
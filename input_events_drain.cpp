@@ -0,0 +1,182 @@
+#include <cassert>
+#include <cstdint>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <gpiod.h>
+
+// Same inputs as input_events, but after each wakeup the request fd is
+// drained: reads continue (non-blocking) until the kernel has no more
+// events, and only then does the loop go back to waiting. During a burst
+// that means one wakeup and several reads instead of a wait plus a read
+// for every buffer-full.
+//
+// Events are counted, not printed. At exit (ctrl-c) a histogram of events
+// per read and events per wakeup is printed, which shows how well the
+// syscalls are being amortized.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+// Events-per-wakeup histogram buckets are powers of two: bucket n counts
+// wakeups with [2^n, 2^(n+1)) events.
+static const int wakeup_buckets = 16;
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static int log2_bucket(uint64_t n)
+{
+    int b = 63 - __builtin_clzll(n);
+    return b < wakeup_buckets ? b : wakeup_buckets - 1;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_drain");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    // Make reads on the request fd non-blocking so an empty fd returns
+    // EAGAIN instead of sleeping. gpiod_line_request_wait_edge_events
+    // polls, so it is not affected.
+    int fd = gpiod_line_request_get_fd(request);
+    int r2 = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    assert(r2 == 0);
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+
+    uint64_t per_read[max_events + 1] = { 0 };      // index is events in read
+    uint64_t per_wakeup[wakeup_buckets] = { 0 };    // log2 buckets
+    uint64_t wakeups = 0;
+    uint64_t reads = 0;
+    uint64_t empty_reads = 0;   // reads that found nothing (EAGAIN)
+    uint64_t total_events = 0;
+    uint64_t max_wakeup = 0;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        int r3 = gpiod_line_request_wait_edge_events(request, -1);
+        if (r3 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r3 == 1);
+
+        wakeups++;
+        uint64_t wakeup_events = 0;
+
+        // Drain. A read that comes back short means the kernel buffer was
+        // empty at that point, so there's no need for one more read just
+        // to get EAGAIN; a full read means there might be more.
+        while (true) {
+            int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+            reads++;
+            if (num_events < 0 && errno == EAGAIN) {
+                empty_reads++;
+                break;
+            }
+            assert(num_events >= 0);
+            per_read[num_events]++;
+            wakeup_events += num_events;
+            if (num_events < max_events)
+                break;
+        }
+
+        if (wakeup_events > 0)
+            per_wakeup[log2_bucket(wakeup_events)]++;
+        if (wakeup_events > max_wakeup)
+            max_wakeup = wakeup_events;
+        total_events += wakeup_events;
+
+    } // while
+
+    printf("%" PRIu64 " events, %" PRIu64 " wakeups, %" PRIu64 " reads (%" PRIu64
+           " empty)\n", total_events, wakeups, reads, empty_reads);
+    if (reads > 0 && wakeups > 0)
+        printf("%.2f events/read, %.2f events/wakeup, %.2f syscalls/event\n",
+               double(total_events) / reads, double(total_events) / wakeups,
+               total_events ? double(reads + wakeups) / total_events : 0.0);
+
+    printf("events per read:\n");
+    for (int i = 1; i <= max_events; i++)
+        if (per_read[i] != 0)
+            printf("  %4d: %" PRIu64 "\n", i, per_read[i]);
+
+    printf("events per wakeup (max %" PRIu64 "):\n", max_wakeup);
+    for (int b = 0; b < wakeup_buckets; b++)
+        if (per_wakeup[b] != 0)
+            printf("  %6llu-%-6llu: %" PRIu64 "\n", 1ULL << b, (2ULL << b) - 1,
+                   per_wakeup[b]);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
@@ -0,0 +1,195 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <gpiod.h>
+#include "event_reactor.h"
+
+// Watch edge events on several line requests, possibly on several chips
+// (e.g. the SoC plus I2C expanders), from one thread using event_reactor.
+//
+// Each argument is one request: a chip path and a list of line offsets.
+//
+// Usage: input_events_epoll [chip:offset[,offset...] ...]
+//   e.g. input_events_epoll /dev/gpiochip0:23,24 /dev/gpiochip2:0,1,2
+//
+// With no arguments, watches GPIO23 and GPIO24 on /dev/gpiochip0 like
+// input_events.
+
+static const char *default_group = "/dev/gpiochip0:23,24";
+
+static const int max_groups = 16;   // requests
+static const int max_lines = 64;    // lines per request
+
+static const int max_events = 32;   // max events to buffer per read
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+// One request (one chip, some lines on it).
+struct line_group {
+    char chip_path[64];
+    unsigned int offsets[max_lines];
+    int num_offsets;
+    gpiod_chip *chip;
+    gpiod_line_request *request;
+    uint64_t last_ns;
+};
+
+
+// Parse "chip:offset,offset,..." into group. Returns false if malformed.
+static bool parse_group(const char *arg, line_group &group)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || colon == arg || size_t(colon - arg) >= sizeof(group.chip_path))
+        return false;
+    memcpy(group.chip_path, arg, colon - arg);
+    group.chip_path[colon - arg] = '\0';
+    group.num_offsets = 0;
+    const char *p = colon + 1;
+    while (*p != '\0') {
+        char *end;
+        unsigned long offset = strtoul(p, &end, 0);
+        if (end == p || group.num_offsets >= max_lines)
+            return false;
+        group.offsets[group.num_offsets++] = offset;
+        p = end;
+        if (*p == ',')
+            p++;
+        else if (*p != '\0')
+            return false;
+    }
+    return group.num_offsets > 0;
+}
+
+
+// Request the group's lines as inputs with edge detection.
+static void request_group(line_group &group)
+{
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, group.offsets,
+                                                 group.num_offsets, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+
+    group.chip = gpiod_chip_open(group.chip_path);
+    assert(group.chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_epoll");
+
+    group.request = gpiod_chip_request_lines(group.chip, request_config, line_config);
+    assert(group.request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    gpiod_line_config_free(line_config);
+
+    group.last_ns = 0;
+}
+
+
+// Per-request handler: print events like input_events, prefixed with the
+// chip so lines on different chips can be told apart.
+static void print_events(gpiod_line_request *request, gpiod_edge_event_buffer *events,
+                         int num_events, void *arg)
+{
+    line_group *group = (line_group *)arg;
+
+    for (int i = 0; i < num_events; i++) {
+        gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+        unsigned long global_seqno = gpiod_edge_event_get_global_seqno(event);
+        unsigned long line_seqno = gpiod_edge_event_get_line_seqno(event);
+        unsigned int pin_num = gpiod_edge_event_get_line_offset(event);
+        unsigned int pin_val =
+            gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0;
+        uint64_t timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+        printf("%s %lu:%lu pin %u = %u @ %" PRIu64, group->chip_path, global_seqno,
+               line_seqno, pin_num, pin_val, timestamp_ns);
+        if (group->last_ns != 0)
+            printf(" +%" PRIu64, timestamp_ns - group->last_ns);
+        group->last_ns = timestamp_ns;
+        printf("\n");
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    static line_group groups[max_groups];
+    int num_groups = 0;
+
+    if (argc == 1) {
+        bool ok = parse_group(default_group, groups[num_groups++]);
+        assert(ok);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (num_groups >= max_groups || !parse_group(argv[i], groups[num_groups])) {
+            fprintf(stderr, "usage: %s [chip:offset[,offset...] ...]\n", argv[0]);
+            return 1;
+        }
+        num_groups++;
+    }
+
+    event_reactor reactor(max_events);
+
+    for (int i = 0; i < num_groups; i++) {
+        request_group(groups[i]);
+        bool ok = reactor.add(groups[i].request, print_events, &groups[i]);
+        assert(ok);
+        printf("%s: %d lines\n", groups[i].chip_path, groups[i].num_offsets);
+    }
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        int r2 = reactor.run_once(-1);
+        if (r2 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r2 > 0);
+
+        // Extra blank line here groups events received in the same wakeup.
+        printf("\n");
+
+    } // while
+
+    for (int i = 0; i < num_groups; i++) {
+        reactor.remove(groups[i].request);
+        gpiod_line_request_release(groups[i].request);
+        groups[i].request = nullptr;
+        gpiod_chip_close(groups[i].chip);
+        groups[i].chip = nullptr;
+    }
+
+    return 0;
+
+} // main
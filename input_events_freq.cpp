@@ -0,0 +1,172 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "freq_meter.h"
+
+// Measure frequency, period, high/low time and duty cycle on each input
+// (see freq_meter.h), e.g. for flow meters or fan tachometers.
+//
+// Edge events only update counters; results are printed once per window,
+// so the output rate doesn't depend on the input frequency.
+//
+// Usage: input_events_freq [window_ms]    (default 1000)
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 64;   // max events to buffer
+
+// Debounce limits the highest measurable frequency to about
+// 1 / (2 * debounce), so it is off here. Use it for mechanical contacts
+// (reed switch flow meters).
+static const unsigned long debounce_us = 0;
+
+static const unsigned long default_window_ms = 1000;
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    unsigned long window_ms = argc > 1 ? strtoul(argv[1], nullptr, 0) : default_window_ms;
+    if (window_ms == 0) {
+        fprintf(stderr, "usage: %s [window_ms]\n", argv[0]);
+        return 1;
+    }
+    const uint64_t window_ns = uint64_t(window_ms) * 1000000;
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_freq");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    printf("debounce time = %lu usec, window = %lu msec\n", debounce_us, window_ms);
+
+    freq_meter meters[gpio_pin_cnt]; // same order as offsets[]
+
+    uint64_t next_report_ns = now_ns() + window_ns;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        int64_t timeout_ns = next_report_ns - now_ns();
+        if (timeout_ns < 0)
+            timeout_ns = 0;
+        int r2 = gpiod_line_request_wait_edge_events(request, timeout_ns);
+        if (r2 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r2 >= 0);
+
+        if (r2 == 1) {
+            int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+            assert(num_events > 0);
+
+            for (int i = 0; i < num_events; i++) {
+                gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+                unsigned int pin_num = gpiod_edge_event_get_line_offset(event);
+                int line = 0;
+                while (line < gpio_pin_cnt - 1 && offsets[line] != pin_num)
+                    line++;
+                meters[line].edge(gpiod_edge_event_get_event_type(event) ==
+                                  GPIOD_EDGE_EVENT_RISING_EDGE,
+                                  gpiod_edge_event_get_timestamp_ns(event));
+            }
+        }
+
+        if (now_ns() < next_report_ns)
+            continue;
+        next_report_ns += window_ns;
+
+        for (int line = 0; line < gpio_pin_cnt; line++) {
+            freq_meter::result r = meters[line].take();
+            if (r.periods == 0) {
+                printf("pin %u: no complete period\n", offsets[line]);
+                continue;
+            }
+            printf("pin %u: %.3f Hz period %.1f us (%.1f..%.1f) high %.1f us"
+                   " low %.1f us duty %.1f%% (%" PRIu64 " periods)\n",
+                   offsets[line], r.freq_hz, r.period_ns / 1e3, r.min_period_ns / 1e3,
+                   r.max_period_ns / 1e3, r.high_ns / 1e3, r.low_ns / 1e3,
+                   r.duty * 100.0, r.periods);
+        }
+
+    } // while
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
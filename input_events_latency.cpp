@@ -0,0 +1,188 @@
+#include <cassert>
+#include <cstdint>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "histogram.h"
+
+// Same inputs as input_events, but instead of printing events this
+// measures how long each edge took to reach userspace.
+//
+// The kernel timestamps each edge (on CLOCK_MONOTONIC, selected with
+// gpiod_line_settings_set_event_clock). Right after each read, the same
+// clock is read again; the difference is the edge-to-userspace latency,
+// which covers interrupt handling, wakeup and scheduling. It is
+// recorded per line in a histogram. Percentiles for the last interval are
+// printed every few seconds, and for the whole run at exit (ctrl-c).
+//
+// Note debounce does not show up here. With debounce on, the kernel
+// timestamps the event when the debounce period expires (in its debounce
+// work function), not at the first edge, so the time from the physical
+// edge to delivery is this latency plus the debounce period.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+static const uint64_t report_ns = 5000000000ULL; // report interval
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void print_latency(const char *label, unsigned int pin_num, const histogram<> &h)
+{
+    if (h.count() == 0) {
+        printf("%s pin %u: no events\n", label, pin_num);
+        return;
+    }
+    printf("%s pin %u: %" PRIu64 " events, usec p50 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+           label, pin_num, h.count(), h.percentile(50) / 1e3, h.percentile(99) / 1e3,
+           h.percentile(99.9) / 1e3, h.max() / 1e3);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    // latency is computed against CLOCK_MONOTONIC, so this must match
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_latency");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+
+    // per line, same order as offsets[]
+    static histogram<> interval[gpio_pin_cnt];  // since last report
+    static histogram<> total[gpio_pin_cnt];     // whole run
+
+    uint64_t next_report_ns = now_ns() + report_ns;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        // Time out at the next report so reports come out even when
+        // no events do.
+        int64_t timeout_ns = next_report_ns - now_ns();
+        if (timeout_ns < 0)
+            timeout_ns = 0;
+        int r2 = gpiod_line_request_wait_edge_events(request, timeout_ns);
+        if (r2 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r2 >= 0);
+
+        if (r2 == 1) {
+
+            int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+            assert(num_events > 0);
+
+            // One clock read per read call; all events in the buffer were
+            // handed to userspace at the same moment.
+            uint64_t read_ns = now_ns();
+
+            for (int i = 0; i < num_events; i++) {
+                gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+                unsigned int pin_num = gpiod_edge_event_get_line_offset(event);
+                uint64_t timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+                uint64_t latency_ns = read_ns > timestamp_ns ? read_ns - timestamp_ns : 0;
+                int line = 0;
+                while (line < gpio_pin_cnt - 1 && offsets[line] != pin_num)
+                    line++;
+                interval[line].record(latency_ns);
+            }
+
+        }
+
+        if (now_ns() >= next_report_ns) {
+            for (int line = 0; line < gpio_pin_cnt; line++) {
+                print_latency("last", offsets[line], interval[line]);
+                total[line].add(interval[line]);
+                interval[line].reset();
+            }
+            next_report_ns += report_ns;
+        }
+
+    } // while
+
+    for (int line = 0; line < gpio_pin_cnt; line++) {
+        total[line].add(interval[line]);
+        print_latency("total", offsets[line], total[line]);
+    }
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
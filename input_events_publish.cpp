@@ -0,0 +1,207 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <gpiod.h>
+#include "edge_record.h"
+#include "shm_ring.h"
+
+// Same inputs as input_events, but instead of printing events they are
+// published into a shared-memory ring (see shm_ring.h) that any number of
+// local processes can read; see shm_consumer for a client.
+//
+// Usage: input_events_publish [-p drop|overwrite|block] [-s socket]
+//
+// Consumers connect to the socket (default /tmp/gpio_events.sock) to get
+// the ring's memfd. The policy says what happens to a consumer that falls
+// a whole ring behind.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+static const uint32_t ring_size = 4096; // events; must be power of 2
+
+static const char *default_socket = "/tmp/gpio_events.sock";
+
+static volatile sig_atomic_t quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    shm_ring_policy policy = shm_ring_overwrite;
+    const char *socket_path = default_socket;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "drop") == 0)
+                policy = shm_ring_drop;
+            else if (strcmp(argv[i], "overwrite") == 0)
+                policy = shm_ring_overwrite;
+            else if (strcmp(argv[i], "block") == 0)
+                policy = shm_ring_block;
+            else
+                argc = 0; // force usage message
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else {
+            argc = 0;
+        }
+    }
+
+    if (argc == 0) {
+        fprintf(stderr, "usage: %s [-p drop|overwrite|block] [-s socket]\n", argv[0]);
+        return 1;
+    }
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_publish");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    // The ring, and the socket consumers use to get it.
+    shm_ring_publisher ring;
+    if (!ring.create(ring_size, policy)) {
+        fprintf(stderr, "%s: can't create ring: %s\n", argv[0], strerror(errno));
+        return 1;
+    }
+
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    assert(sock >= 0);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    unlink(socket_path); // left over from a previous run
+    if (bind(sock, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, 16) != 0) {
+        fprintf(stderr, "%s: can't listen on %s: %s\n", argv[0], socket_path, strerror(errno));
+        return 1;
+    }
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+    printf("publishing %u-event ring (%s) on %s\n", ring_size,
+           policy == shm_ring_drop ? "drop" : policy == shm_ring_block ? "block" : "overwrite",
+           socket_path);
+
+    uint64_t published = 0;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    // Wait on both the request (events) and the socket (new consumers).
+    pollfd fds[2];
+    fds[0].fd = gpiod_line_request_get_fd(request);
+    fds[0].events = POLLIN;
+    fds[1].fd = sock;
+    fds[1].events = POLLIN;
+
+    while (!quitting) {
+
+        int r2 = poll(fds, 2, -1);
+        if (r2 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r2 > 0);
+
+        if (fds[1].revents & POLLIN) {
+            if (shm_ring_serve(sock, ring.fd()))
+                printf("consumer connected (%d attached)\n", ring.consumers());
+        }
+
+        if (fds[0].revents & POLLIN) {
+
+            int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+            assert(num_events > 0);
+
+            // (with the block policy, ctrl-c ends a wait for a slow consumer)
+            for (int i = 0; i < num_events && !quitting; i++) {
+                edge_record rec;
+                edge_record_set(rec, gpiod_edge_event_buffer_get_event(events, i));
+                published += ring.publish(rec, &quitting);
+            }
+
+            // one wakeup (if anyone is asleep) per read
+            ring.notify();
+        }
+
+    } // while
+
+    printf("%" PRIu64 " events published, %" PRIu64 " dropped\n", published, ring.dropped());
+
+    close(sock);
+    unlink(socket_path);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
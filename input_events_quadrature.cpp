@@ -0,0 +1,164 @@
+#include <cassert>
+#include <cstdint>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "quadrature.h"
+
+// Decode a quadrature encoder on the 'a' and 'b' inputs (see quadrature.h).
+//
+// Edge events feed the decoder; position, velocity and error counts are
+// printed a few times a second rather than per event, so the loop keeps up
+// with fast encoders.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 64;   // max events to buffer
+
+// Encoder edges can come faster than any useful debounce time, so don't.
+static const unsigned long debounce_us = 0;
+
+static const uint64_t report_ns = 200000000; // 5 reports/sec
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void print_decoder(const quadrature_decoder &decoder)
+{
+    printf("position %" PRId64 " velocity %.1f counts/sec direction %+d"
+           " (fwd %" PRIu64 " rev %" PRIu64 " illegal %" PRIu64 ")\n",
+           decoder.position, decoder.velocity(now_ns()), decoder.direction(),
+           decoder.forward, decoder.reverse, decoder.illegal);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    // order matters: the decoder takes line 0 as 'a' and line 1 as 'b'
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_quadrature");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    // Start the decoder from the current line values. Edge detection is
+    // already on, so nothing can change unseen between this and the first
+    // read.
+    gpiod_line_value values[gpio_pin_cnt];
+    int r2 = gpiod_line_request_get_values(request, values);
+    assert(r2 == 0);
+
+    quadrature_decoder decoder;
+    decoder.reset(values[0] == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0,
+                  values[1] == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0, now_ns());
+
+    uint64_t next_report_ns = now_ns() + report_ns;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        int64_t timeout_ns = next_report_ns - now_ns();
+        if (timeout_ns < 0)
+            timeout_ns = 0;
+        int r3 = gpiod_line_request_wait_edge_events(request, timeout_ns);
+        if (r3 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r3 >= 0);
+
+        if (r3 == 1) {
+            int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+            assert(num_events > 0);
+
+            for (int i = 0; i < num_events; i++) {
+                gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+                unsigned line = gpiod_edge_event_get_line_offset(event) == a_gpio_num ? 0 : 1;
+                unsigned value =
+                    gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0;
+                decoder.edge(line, value, gpiod_edge_event_get_timestamp_ns(event));
+            }
+        }
+
+        if (now_ns() >= next_report_ns) {
+            print_decoder(decoder);
+            next_report_ns += report_ns;
+        }
+
+    } // while
+
+    print_decoder(decoder);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
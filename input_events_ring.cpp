@@ -0,0 +1,230 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h> // usleep()
+#include <thread>
+#include <gpiod.h>
+#include "edge_record.h"
+#include "spsc_ring.h"
+
+// Same as input_events, but the thread reading events does no printing.
+// It only copies each event into a lock-free ring; a second thread takes
+// events out of the ring and prints them. A slow terminal or pipe then
+// stalls the writer thread instead of the reads, and the kernel's event
+// buffer keeps getting emptied.
+//
+// If the ring fills (writer can't keep up for long enough), new events are
+// dropped and counted rather than blocking the reader. Ring statistics are
+// printed to stderr once a second and at exit.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+static const size_t ring_size = 4096; // events; must be power of 2
+
+static const int64_t wait_timeout_ns = 100000000; // 100 msec
+
+static std::atomic<bool> quitting(false);
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+static spsc_ring<edge_record, ring_size> ring;
+
+// Counters. Each is written by only one thread.
+static std::atomic<uint64_t> events_pushed(0);  // reader
+static std::atomic<uint64_t> events_dropped(0); // reader
+static std::atomic<uint64_t> ring_max(0);       // reader: high water mark
+static std::atomic<uint64_t> events_written(0); // writer
+
+
+static void print_stats(const char *label)
+{
+    fprintf(stderr, "%s: pushed %" PRIu64 " written %" PRIu64 " dropped %"
+            PRIu64 " ring %zu/%zu (max %" PRIu64 ")\n", label,
+            events_pushed.load(), events_written.load(), events_dropped.load(),
+            ring.size(), ring.get_capacity(), ring_max.load());
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+// Writer thread: empty the ring, printing each event the same way
+// input_events does. When the ring is empty, sleep a little.
+static void writer()
+{
+    uint64_t last_ns = 0;
+    uint64_t stats_ns = now_ns() + 1000000000;
+    edge_record rec;
+
+    while (true) {
+
+        bool got_one = false;
+
+        while (ring.pop(rec)) {
+            printf("%" PRIu32 ":%" PRIu32 " pin %" PRIu32 " = %" PRIu32 " @ %" PRIu64,
+                   rec.global_seqno, rec.line_seqno, rec.offset, rec.rising,
+                   rec.timestamp_ns);
+            if (last_ns != 0)
+                printf(" +%" PRIu64, rec.timestamp_ns - last_ns);
+            last_ns = rec.timestamp_ns;
+            printf("\n");
+            events_written.store(events_written.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+            got_one = true;
+        }
+
+        if (got_one)
+            fflush(stdout);
+
+        if (now_ns() >= stats_ns) {
+            print_stats("ring");
+            stats_ns += 1000000000;
+        }
+
+        // quit only after the ring has been drained
+        if (quitting && ring.size() == 0)
+            break;
+
+        if (!got_one)
+            usleep(1000);
+
+    } // while
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    // Edge event buffer; the reader copies out of this into the ring.
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_ring");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+    printf("ring size = %zu events\n", ring.get_capacity());
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    // Block SIGINT while starting the writer so it inherits a mask with
+    // SIGINT blocked; that way ctrl-c is always delivered to this thread
+    // and interrupts the wait below.
+    sigset_t sigint_set;
+    sigemptyset(&sigint_set);
+    sigaddset(&sigint_set, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &sigint_set, nullptr);
+    std::thread writer_thread(writer);
+    pthread_sigmask(SIG_UNBLOCK, &sigint_set, nullptr);
+
+    while (!quitting) {
+
+        // Timeout is so 'quitting' is noticed even if the signal arrives
+        // between the check above and the wait.
+        int r2 = gpiod_line_request_wait_edge_events(request, wait_timeout_ns);
+        if (r2 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r2 >= 0);
+        if (r2 == 0)
+            continue; // timeout
+
+        int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+        assert(num_events > 0);
+
+        // Copy events into the ring. Nothing in here makes a system call.
+        for (int i = 0; i < num_events; i++) {
+            edge_record rec;
+            edge_record_set(rec, gpiod_edge_event_buffer_get_event(events, i));
+            if (ring.push(rec))
+                events_pushed.store(events_pushed.load(std::memory_order_relaxed) + 1,
+                                    std::memory_order_relaxed);
+            else
+                events_dropped.store(events_dropped.load(std::memory_order_relaxed) + 1,
+                                     std::memory_order_relaxed);
+        }
+
+        uint64_t occupancy = ring.size();
+        if (occupancy > ring_max.load(std::memory_order_relaxed))
+            ring_max.store(occupancy, std::memory_order_relaxed);
+
+    } // while
+
+    quitting = true;
+    writer_thread.join();
+
+    print_stats("exit");
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
@@ -0,0 +1,367 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+
+// Same inputs as input_events, with per-line protection against edge
+// storms.
+//
+// All lines in a request share one kernel event FIFO. If one line starts
+// chattering (a bad contact, a floating input) it fills the FIFO and the
+// other lines' events get thrown away along with its own. Here each
+// line's event rate is measured over a short window; a line going over
+// the limit has its edge detection turned off (the other lines keep
+// theirs; gpiod_line_request_reconfigure_lines takes a setting per line)
+// and is sampled at a low rate instead. When a second's worth of samples
+// shows it has calmed down, edge detection is turned back on.
+//
+// A line in a storm also has its debounce cleared. On chips without
+// hardware debounce (the Pi's bcm2835) the kernel debounces in software,
+// and that keeps an interrupt armed on both edges even with edge detection
+// off; only with both off does the storm stop costing interrupts.
+//
+// Debounce also limits what can be detected: a debounced line delivers an
+// edge only after it has been stable for the period (rounded up to whole
+// jiffies), so with 1 msec it delivers well under 1000 events/sec however
+// fast it chatters, and chatter faster than the period is absorbed by the
+// debounce itself. The threshold has to be below that, hence the default
+// of 100.
+//
+// While a line's edges are off nobody counts them, so "suppressed" is a
+// lower bound: edges already queued when the storm was detected (these
+// are thrown away) plus changes seen by the sampling.
+//
+// Usage: input_events_storm [-t events/sec] [-s sample_ms] [-q changes/sec]
+//
+//   -t   storm threshold per line, default 100 (must be below
+//        1000000 / debounce_us)
+//   -s   sampling interval during a storm, default 10
+//   -q   a line is calm when sampling sees fewer than this, default 5
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+static const uint64_t rate_window_ns = 100000000;   // storm detection window
+static const uint64_t calm_window_ns = 1000000000;  // calm detection window
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+struct line_state {
+    bool storm;
+    int value;                  // last printed or sampled
+    uint64_t window_events;     // events in the current rate window
+    uint64_t storm_start_ns;
+    uint64_t calm_start_ns;     // start of the current calm window
+    uint64_t calm_changes;      // changes sampled in it
+    // totals
+    uint64_t episodes;
+    uint64_t suppressed;
+    uint64_t storm_ns;
+};
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+// Apply each line's edge detection (off if in a storm, both otherwise).
+static void configure_lines(gpiod_line_request *request, const unsigned int *offsets,
+                            const line_state *lines)
+{
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    // A line in a storm gets neither edge detection nor debounce, so the
+    // kernel releases its interrupt.
+    for (int line = 0; line < gpio_pin_cnt; line++) {
+        bool storm = lines[line].storm;
+        gpiod_line_settings_set_edge_detection(settings, storm ? GPIOD_LINE_EDGE_NONE
+                                                               : GPIOD_LINE_EDGE_BOTH);
+        gpiod_line_settings_set_debounce_period_us(settings, storm ? 0 : debounce_us);
+        int r = gpiod_line_config_add_line_settings(line_config, &offsets[line], 1, settings);
+        assert(r == 0);
+    }
+
+    gpiod_line_settings_free(settings);
+
+    int r = gpiod_line_request_reconfigure_lines(request, line_config);
+    assert(r == 0);
+
+    gpiod_line_config_free(line_config);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    long storm_rate = 100;
+    long sample_ms = 10;
+    long calm_rate = 5;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            storm_rate = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            sample_ms = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            calm_rate = strtol(argv[++i], nullptr, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-t events/sec] [-s sample_ms] [-q changes/sec]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (storm_rate <= 0 || sample_ms <= 0 || calm_rate <= 0) {
+        fprintf(stderr, "%s: arguments must be positive\n", argv[0]);
+        return 1;
+    }
+
+    // Debounce limits how many events a line can deliver (see above).
+    if (debounce_us > 0 && uint64_t(storm_rate) >= 1000000 / debounce_us) {
+        fprintf(stderr, "%s: with %lu usec debounce a line can't reach %ld events/sec;"
+                " use -t below %lu\n", argv[0], debounce_us, storm_rate,
+                1000000 / debounce_us);
+        return 1;
+    }
+
+    // Counts per window.
+    const uint64_t storm_count = uint64_t(storm_rate) * rate_window_ns / 1000000000;
+    const uint64_t calm_count = uint64_t(calm_rate) * calm_window_ns / 1000000000;
+    const uint64_t sample_ns = uint64_t(sample_ms) * 1000000;
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_storm");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+    printf("storm above %ld events/sec, sample every %ld msec, calm below %ld changes/sec\n",
+           storm_rate, sample_ms, calm_rate);
+
+    line_state lines[gpio_pin_cnt];
+    memset(lines, 0, sizeof(lines));
+
+    gpiod_line_value values[gpio_pin_cnt];
+    int r2 = gpiod_line_request_get_values(request, values);
+    assert(r2 == 0);
+    for (int line = 0; line < gpio_pin_cnt; line++)
+        lines[line].value = values[line] == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0;
+
+    int storms = 0; // lines currently in a storm
+    uint64_t window_start_ns = now_ns();
+    uint64_t next_sample_ns = 0;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        // Wake up for the end of the rate window, or the next sample if
+        // any line is being sampled.
+        uint64_t t_ns = now_ns();
+        uint64_t wake_ns = window_start_ns + rate_window_ns;
+        if (storms > 0 && next_sample_ns < wake_ns)
+            wake_ns = next_sample_ns;
+        int64_t timeout_ns = wake_ns > t_ns ? wake_ns - t_ns : 0;
+
+        int r3 = gpiod_line_request_wait_edge_events(request, timeout_ns);
+        if (r3 < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(r3 >= 0);
+
+        if (r3 == 1) {
+
+            int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+            assert(num_events > 0);
+
+            for (int i = 0; i < num_events; i++) {
+                gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+                unsigned int pin_num = gpiod_edge_event_get_line_offset(event);
+                int line = 0;
+                while (line < gpio_pin_cnt - 1 && offsets[line] != pin_num)
+                    line++;
+
+                if (lines[line].storm) {
+                    // queued before edges were turned off
+                    lines[line].suppressed++;
+                    continue;
+                }
+
+                unsigned long global_seqno = gpiod_edge_event_get_global_seqno(event);
+                unsigned long line_seqno = gpiod_edge_event_get_line_seqno(event);
+                unsigned int pin_val =
+                    gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0;
+                uint64_t timestamp_ns = gpiod_edge_event_get_timestamp_ns(event);
+
+                printf("%lu:%lu pin %u = %u @ %" PRIu64 "\n", global_seqno, line_seqno,
+                       pin_num, pin_val, timestamp_ns);
+
+                lines[line].value = pin_val;
+                lines[line].window_events++;
+            }
+        }
+
+        t_ns = now_ns();
+
+        // Look for new storms after every read, not just at the end of the
+        // window, so a storm is cut off as soon as it is over the limit.
+        bool new_storm = false;
+        for (int line = 0; line < gpio_pin_cnt; line++) {
+            line_state &ls = lines[line];
+            if (ls.storm || ls.window_events <= storm_count)
+                continue;
+            printf("pin %u storm: %" PRIu64 " events in %" PRIu64 " msec: edges off\n",
+                   offsets[line], ls.window_events, (t_ns - window_start_ns) / 1000000);
+            ls.storm = true;
+            ls.storm_start_ns = t_ns;
+            ls.calm_start_ns = t_ns;
+            ls.calm_changes = 0;
+            ls.episodes++;
+            if (storms++ == 0)
+                next_sample_ns = t_ns + sample_ns;
+            new_storm = true;
+        }
+        if (new_storm)
+            configure_lines(request, offsets, lines);
+
+        // Sample lines in a storm; end storms that have calmed down.
+        if (storms > 0 && t_ns >= next_sample_ns) {
+            bool reconfigure = false;
+            for (int line = 0; line < gpio_pin_cnt; line++) {
+                line_state &ls = lines[line];
+                if (!ls.storm)
+                    continue;
+                gpiod_line_value v = gpiod_line_request_get_value(request, offsets[line]);
+                assert(v != GPIOD_LINE_VALUE_ERROR);
+                int value = v == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0;
+                if (value != ls.value) {
+                    ls.value = value;
+                    ls.calm_changes++;
+                    ls.suppressed++;
+                }
+                if (t_ns - ls.calm_start_ns < calm_window_ns)
+                    continue;
+                if (ls.calm_changes < calm_count) {
+                    // calm: edges back on
+                    ls.storm = false;
+                    ls.storm_ns += t_ns - ls.storm_start_ns;
+                    ls.window_events = 0;
+                    storms--;
+                    reconfigure = true;
+                    printf("pin %u calm after %.3f sec, now %d: edges on\n", offsets[line],
+                           (t_ns - ls.storm_start_ns) / 1e9, ls.value);
+                } else {
+                    ls.calm_start_ns = t_ns;
+                    ls.calm_changes = 0;
+                }
+            }
+            if (reconfigure)
+                configure_lines(request, offsets, lines);
+            next_sample_ns += sample_ns;
+            if (next_sample_ns < t_ns)
+                next_sample_ns = t_ns + sample_ns;
+        }
+
+        // End of the rate window.
+        if (t_ns >= window_start_ns + rate_window_ns) {
+            for (int line = 0; line < gpio_pin_cnt; line++)
+                lines[line].window_events = 0;
+            window_start_ns = t_ns;
+        }
+
+    } // while
+
+    uint64_t end_ns = now_ns();
+    for (int line = 0; line < gpio_pin_cnt; line++) {
+        line_state &ls = lines[line];
+        if (ls.storm)
+            ls.storm_ns += end_ns - ls.storm_start_ns;
+        printf("pin %u: %" PRIu64 " storms, %.3f sec total, at least %" PRIu64
+               " events suppressed%s\n", offsets[line], ls.episodes, ls.storm_ns / 1e9,
+               ls.suppressed, ls.storm ? " (still in storm)" : "");
+    }
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
@@ -0,0 +1,267 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h> // alarm()
+#include <gpiod.h>
+#include "uring_reader.h"
+
+// Same inputs as input_events, but events are read with io_uring (see
+// uring_reader.h): a read is always queued on the request fd, and each
+// wakeup is one io_uring_enter instead of a poll plus a read.
+//
+// Usage: input_events_uring          print events, like input_events
+//        input_events_uring -b <sec> benchmark
+//
+// The benchmark runs the gpiod wait/read loop for <sec> seconds, then the
+// io_uring loop for <sec> seconds, without printing events, and reports
+// syscalls per event and CPU time per event for each. Both loops see the
+// same edges only if the input is driven steadily (e.g. from a signal
+// generator) for the whole run.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = uring_reader::max_events; // max events to buffer
+
+static const unsigned long debounce_us = 1000; // debounce time
+
+static volatile sig_atomic_t quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+// SIGALRM ends a benchmark phase
+static volatile sig_atomic_t phase_done = false;
+
+static void alarm_handler(int notused)
+{
+    phase_done = true;
+}
+
+struct bench_result {
+    uint64_t events;
+    uint64_t syscalls;
+    uint64_t cpu_ns;
+};
+
+
+static uint64_t cpu_ns()
+{
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t(ru.ru_utime.tv_sec) + ru.ru_stime.tv_sec) * 1000000000 +
+           (uint64_t(ru.ru_utime.tv_usec) + ru.ru_stime.tv_usec) * 1000;
+}
+
+
+static void print_event(const gpio_v2_line_event &ev)
+{
+    static uint64_t last_ns = 0;
+    unsigned int pin_val = ev.id == GPIO_V2_LINE_EVENT_RISING_EDGE ? 1 : 0;
+    printf("%u:%u pin %u = %u @ %" PRIu64, ev.seqno, ev.line_seqno, ev.offset,
+           pin_val, uint64_t(ev.timestamp_ns));
+    if (last_ns != 0)
+        printf(" +%" PRIu64, uint64_t(ev.timestamp_ns) - last_ns);
+    last_ns = ev.timestamp_ns;
+    printf("\n");
+}
+
+
+// uring_reader handler when printing
+static void print_events(const gpio_v2_line_event *events, int num_events, void *arg)
+{
+    for (int i = 0; i < num_events; i++)
+        print_event(events[i]);
+    // Extra blank line here groups events received in the same read.
+    printf("\n");
+}
+
+
+// uring_reader handler when benchmarking
+static void count_events(const gpio_v2_line_event *events, int num_events, void *arg)
+{
+    *(uint64_t *)arg += num_events;
+}
+
+
+// The existing loop from input_events, minus the printing. Two syscalls
+// per wakeup: the poll in wait_edge_events and the read in
+// read_edge_events.
+static bench_result bench_gpiod(gpiod_line_request *request, unsigned seconds)
+{
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    bench_result result = { 0, 0, 0 };
+    phase_done = false;
+    alarm(seconds);
+    uint64_t start_cpu = cpu_ns();
+
+    while (!phase_done && !quitting) {
+        int r = gpiod_line_request_wait_edge_events(request, -1);
+        result.syscalls++;
+        if (r < 0 && errno == EINTR)
+            break;
+        assert(r == 1);
+        int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+        result.syscalls++;
+        assert(num_events > 0);
+        result.events += num_events;
+    }
+
+    result.cpu_ns = cpu_ns() - start_cpu;
+    gpiod_edge_event_buffer_free(events);
+    return result;
+}
+
+
+static bench_result bench_uring(gpiod_line_request *request, unsigned seconds)
+{
+    bench_result result = { 0, 0, 0 };
+
+    uring_reader reader;
+    if (!reader.init()) {
+        fprintf(stderr, "io_uring not available: %s\n", strerror(errno));
+        return result;
+    }
+    reader.add(gpiod_line_request_get_fd(request), count_events, &result.events);
+
+    phase_done = false;
+    alarm(seconds);
+    uint64_t start_cpu = cpu_ns();
+
+    while (!phase_done && !quitting) {
+        int r = reader.wait();
+        if (r < 0 && errno == EINTR)
+            break;
+        assert(r >= 0);
+    }
+
+    result.cpu_ns = cpu_ns() - start_cpu;
+    result.syscalls = reader.syscalls();
+    return result;
+}
+
+
+static void print_result(const char *name, const bench_result &r)
+{
+    if (r.events == 0) {
+        printf("%-6s no events\n", name);
+        return;
+    }
+    printf("%-6s %10" PRIu64 " events %10" PRIu64 " syscalls %6.3f syscalls/event"
+           " %8.0f cpu ns/event\n", name, r.events, r.syscalls,
+           double(r.syscalls) / r.events, double(r.cpu_ns) / r.events);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    unsigned bench_seconds = 0;
+
+    if (argc == 3 && strcmp(argv[1], "-b") == 0) {
+        bench_seconds = strtoul(argv[2], nullptr, 0);
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-b <seconds>]\n", argv[0]);
+        return 1;
+    }
+
+    // Line settings, line config, chip, and request are all the same as in
+    // input_events (see there for details).
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_events_uring");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    if (bench_seconds > 0) {
+
+        signal(SIGALRM, alarm_handler);
+
+        printf("wait/read loop for %u sec...\n", bench_seconds);
+        bench_result gpiod_result = bench_gpiod(request, bench_seconds);
+        printf("io_uring loop for %u sec...\n", bench_seconds);
+        bench_result uring_result = bench_uring(request, bench_seconds);
+
+        print_result("gpiod", gpiod_result);
+        print_result("uring", uring_result);
+
+    } else {
+
+        uring_reader reader;
+        if (!reader.init()) {
+            fprintf(stderr, "io_uring not available: %s\n", strerror(errno));
+            return 1;
+        }
+        reader.add(gpiod_line_request_get_fd(request), print_events, nullptr);
+
+        while (!quitting) {
+            int r2 = reader.wait();
+            if (r2 < 0 && errno == EINTR)
+                break; // ctrl-c
+            assert(r2 > 0);
+        }
+
+    }
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    return 0;
+
+} // main
@@ -0,0 +1,346 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+
+// Same inputs as input_simple and input_events, but switching between the
+// two methods depending on how busy the lines are (the idea is the one the
+// Linux network stack calls NAPI).
+//
+// Edge events are the cheap way to watch quiet lines: nothing happens
+// until a line changes. But every edge is an interrupt plus a wakeup, so a
+// noisy or bouncing line can keep a core busy doing nothing but that.
+// Polling costs the same whatever the lines do.
+//
+// So: start with edge events. Count them over a short window; if the rate
+// goes over the high threshold, turn edge detection off on the lines
+// (gpiod_line_request_reconfigure_lines, no release needed) and poll the
+// values with gpiod_line_request_get_values every poll interval. While
+// polling, count the changes seen; once a whole window goes by below the
+// low threshold (and at least a minimum time has been spent polling),
+// turn edge detection back on.
+//
+// Polling only sees the state at each poll, so it can miss pulses shorter
+// than the interval; that is the price of not being interrupted by them.
+//
+// Usage: input_hybrid [-h events/sec] [-l changes/sec] [-i poll_us]
+//
+// Changes are printed as in input_simple, mode switches as they happen,
+// and a summary at exit.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIOs that will be used as inputs
+static const int a_gpio_num = 23;   // GPIO23 is 'a' input
+static const int b_gpio_num = 24;   // GPIO24 is 'b' input
+static const int gpio_pin_cnt = 2;  // how many pins we're using
+
+static const int max_events = 32;   // max events to buffer
+
+// No kernel debounce, in either mode. On chips without hardware debounce
+// (the Pi's bcm2835) the kernel debounces in software, which keeps an
+// interrupt armed on both edges even with edge detection off, so polling
+// would shed nothing. Debounce would also hide the rate being measured:
+// a 1 msec period lets through at most about 1000 events/sec per line,
+// whatever the line is really doing, and the high threshold could never
+// be reached. (Polling is its own filter: it sees at most one change per
+// line per interval.)
+static const unsigned long debounce_us = 0;
+
+static const uint64_t window_ns = 100000000;        // rate measured over 100 msec
+static const uint64_t min_poll_ns = 1000000000;     // poll at least this long
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void sleep_until(uint64_t t_ns)
+{
+    timespec ts;
+    ts.tv_sec = t_ns / 1000000000;
+    ts.tv_nsec = t_ns % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr); // EINTR is fine
+}
+
+
+// Line config for the inputs with the given edge detection. The two modes
+// differ only in that.
+static gpiod_line_config *make_line_config(const unsigned int *offsets,
+                                           gpiod_line_edge edge)
+{
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+    gpiod_line_settings_set_edge_detection(settings, edge);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    gpiod_line_settings_set_debounce_period_us(settings, debounce_us);
+    gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r = gpiod_line_config_add_line_settings(line_config, offsets, gpio_pin_cnt, settings);
+    assert(r == 0);
+
+    gpiod_line_settings_free(settings);
+
+    return line_config;
+}
+
+
+// Print lines whose value differs from 'values', and update 'values'.
+// Returns the number that changed.
+static int print_changes(const unsigned int *offsets, int *values,
+                         const gpiod_line_value *values_new)
+{
+    int changed = 0;
+    for (int i = 0; i < gpio_pin_cnt; i++) {
+        int v = values_new[i] == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0;
+        if (v != values[i]) {
+            printf("pin %u = %d\n", offsets[i], v);
+            values[i] = v;
+            changed++;
+        }
+    }
+    return changed;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    long high_rate = 5000;  // events/sec; above this, poll
+    long low_rate = 500;    // changes/sec; below this, back to events
+    long poll_us = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            high_rate = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            low_rate = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            poll_us = strtol(argv[++i], nullptr, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-h events/sec] [-l changes/sec] [-i poll_us]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (poll_us <= 0 || low_rate >= high_rate) {
+        fprintf(stderr, "%s: need poll_us > 0 and low rate < high rate\n", argv[0]);
+        return 1;
+    }
+
+    // Counts per window that trigger a switch.
+    const uint64_t high_count = uint64_t(high_rate) * window_ns / 1000000000;
+    const uint64_t low_count = uint64_t(low_rate) * window_ns / 1000000000;
+
+    gpiod_edge_event_buffer *events = gpiod_edge_event_buffer_new(max_events);
+    assert(events != nullptr);
+
+    const unsigned int offsets[gpio_pin_cnt] = {
+        a_gpio_num,
+        b_gpio_num
+    };
+
+    // Both configs are kept for switching back and forth.
+    gpiod_line_config *events_config = make_line_config(offsets, GPIOD_LINE_EDGE_BOTH);
+    gpiod_line_config *poll_config = make_line_config(offsets, GPIOD_LINE_EDGE_NONE);
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    assert(chip != nullptr);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "input_hybrid");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, events_config);
+    assert(request != nullptr);
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    printf("debounce time = %lu usec\n", debounce_us); // reminder
+    printf("poll above %ld events/sec, back to events below %ld changes/sec\n",
+           high_rate, low_rate);
+
+    // Current value of each line, as last printed.
+    int values[gpio_pin_cnt];
+    gpiod_line_value values_new[gpio_pin_cnt];
+    int r1 = gpiod_line_request_get_values(request, values_new);
+    assert(r1 == 0);
+    for (int i = 0; i < gpio_pin_cnt; i++)
+        values[i] = values_new[i] == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0;
+
+    bool polling = false;
+    uint64_t mode_start_ns = now_ns();
+    uint64_t window_start_ns = mode_start_ns;
+    uint64_t window_count = 0;      // events (or changes, when polling)
+    uint64_t next_poll_ns = 0;
+
+    // for the summary
+    uint64_t switches = 0;
+    uint64_t event_count = 0, poll_count = 0, poll_changes = 0, stale_events = 0;
+    uint64_t events_mode_ns = 0, poll_mode_ns = 0;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        uint64_t t_ns;
+
+        if (!polling) {
+
+            // Wait no longer than the end of the window so the rate gets
+            // checked even if events stop.
+            t_ns = now_ns();
+            uint64_t window_end_ns = window_start_ns + window_ns;
+            int64_t timeout_ns = window_end_ns > t_ns ? window_end_ns - t_ns : 0;
+            int r2 = gpiod_line_request_wait_edge_events(request, timeout_ns);
+            if (r2 < 0 && errno == EINTR)
+                break; // ctrl-c
+            assert(r2 >= 0);
+
+            if (r2 == 1) {
+                int num_events = gpiod_line_request_read_edge_events(request, events, max_events);
+                assert(num_events > 0);
+                for (int i = 0; i < num_events; i++) {
+                    gpiod_edge_event *event = gpiod_edge_event_buffer_get_event(events, i);
+                    unsigned int pin_num = gpiod_edge_event_get_line_offset(event);
+                    int v = gpiod_edge_event_get_event_type(event) ==
+                            GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0;
+                    int line = 0;
+                    while (line < gpio_pin_cnt - 1 && offsets[line] != pin_num)
+                        line++;
+                    if (v != values[line]) {
+                        printf("pin %u = %d\n", pin_num, v);
+                        values[line] = v;
+                    }
+                }
+                event_count += num_events;
+                window_count += num_events;
+            }
+
+        } else {
+
+            sleep_until(next_poll_ns);
+            next_poll_ns += poll_us * 1000;
+
+            int r3 = gpiod_line_request_get_values(request, values_new);
+            assert(r3 == 0);
+            int changed = print_changes(offsets, values, values_new);
+            poll_count++;
+            poll_changes += changed;
+            window_count += changed;
+
+            // If the loop fell behind, don't try to catch up.
+            t_ns = now_ns();
+            if (next_poll_ns < t_ns)
+                next_poll_ns = t_ns + poll_us * 1000;
+        }
+
+        t_ns = now_ns();
+        if (t_ns < window_start_ns + window_ns)
+            continue;
+
+        // End of a window: decide whether to switch.
+
+        if (!polling && window_count > high_count) {
+
+            printf("%" PRIu64 " events in %" PRIu64 " msec: polling\n", window_count,
+                   (t_ns - window_start_ns) / 1000000);
+
+            int r4 = gpiod_line_request_reconfigure_lines(request, poll_config);
+            assert(r4 == 0);
+
+            // Edges queued before detection went off are stale now;
+            // polling reads the actual values.
+            while (gpiod_line_request_wait_edge_events(request, 0) == 1) {
+                int n = gpiod_line_request_read_edge_events(request, events, max_events);
+                assert(n > 0);
+                stale_events += n;
+            }
+
+            events_mode_ns += t_ns - mode_start_ns;
+            mode_start_ns = t_ns;
+            next_poll_ns = t_ns;
+            polling = true;
+            switches++;
+
+        } else if (polling && window_count < low_count && t_ns - mode_start_ns >= min_poll_ns) {
+
+            printf("%" PRIu64 " changes in %" PRIu64 " msec: events\n", window_count,
+                   (t_ns - window_start_ns) / 1000000);
+
+            int r5 = gpiod_line_request_reconfigure_lines(request, events_config);
+            assert(r5 == 0);
+
+            // A change between the last poll and edge detection coming on
+            // would be missed, so read once more now that it's on.
+            int r6 = gpiod_line_request_get_values(request, values_new);
+            assert(r6 == 0);
+            print_changes(offsets, values, values_new);
+
+            poll_mode_ns += t_ns - mode_start_ns;
+            mode_start_ns = t_ns;
+            polling = false;
+            switches++;
+        }
+
+        window_start_ns = t_ns;
+        window_count = 0;
+
+    } // while
+
+    uint64_t end_ns = now_ns();
+    if (polling)
+        poll_mode_ns += end_ns - mode_start_ns;
+    else
+        events_mode_ns += end_ns - mode_start_ns;
+
+    printf("%" PRIu64 " mode switches\n", switches);
+    printf("events: %.3f sec, %" PRIu64 " events (%" PRIu64 " stale at switch)\n",
+           events_mode_ns / 1e9, event_count, stale_events);
+    printf("poll:   %.3f sec, %" PRIu64 " polls, %" PRIu64 " changes\n",
+           poll_mode_ns / 1e9, poll_count, poll_changes);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    gpiod_line_config_free(poll_config);
+    poll_config = nullptr;
+
+    gpiod_line_config_free(events_config);
+    events_config = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    gpiod_edge_event_buffer_free(events);
+    events = nullptr;
+
+    return 0;
+
+} // main
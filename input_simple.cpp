@@ -1,9 +1,16 @@
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
 #include <errno.h>
 #include <signal.h> // ctrl-c handler
 #include <stdio.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
 #include <gpiod.h>
+#include "histogram.h"
 
 extern "C" {
 void gpiod_line_config_show(gpiod_line_config*);
@@ -13,6 +20,18 @@ void gpiod_line_request_show(gpiod_line_request*);
 };
 
 // This configures two pins as inputs then polls them to see when they change.
+//
+// Usage: input_simple [rate_hz]    (default 1000)
+//
+// Samples are paced by a timerfd on CLOCK_MONOTONIC with an absolute
+// start time and a fixed interval, so the sample times don't drift with
+// the cost of the get_values ioctl or with scheduling delays (a sleep
+// after each sample would add both to every period). A read of the
+// timerfd returns how many intervals expired since the last read; more
+// than one means deadlines were missed.
+//
+// At exit, the spacing between actual samples (a histogram) and the
+// number of missed deadlines are printed.
 
 static const char *chip_path = "/dev/gpiochip0";
 
@@ -23,6 +42,8 @@ static const int gpio_pin_cnt = 2;  // how many pins we're using
 
 static const unsigned long debounce_us = 1000; // debounce time
 
+static const long default_rate_hz = 1000;
+
 static bool quitting = false;
 
 static void ctrl_c_handler(int notused)
@@ -31,9 +52,24 @@ static void ctrl_c_handler(int notused)
 }
 
 
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
 int main(int argc, char *argv[])
 {
 
+    long rate_hz = argc > 1 ? strtol(argv[1], nullptr, 0) : default_rate_hz;
+    if (argc > 2 || rate_hz <= 0 || rate_hz > 1000000000) {
+        fprintf(stderr, "usage: %s [rate_hz]\n", argv[0]);
+        return 1;
+    }
+    const uint64_t period_ns = 1000000000 / rate_hz;
+
     // Allocate a new struct gpiod_line_settings and initialize it with
     // defaults. All userspace (no kernel calls). If lines need to be
     // different (e.g. different debounce time) then there needs to be more
@@ -125,9 +161,14 @@ int main(int argc, char *argv[])
     //chip = nullptr;
 
     printf("debounce time = %lu usec\n", debounce_us); // reminder
+    printf("sample rate = %ld Hz (%" PRIu64 " nsec)\n", rate_hz, period_ns);
 
-    // ctrl-c sets 'quitting' flag
-    signal(SIGINT, ctrl_c_handler);
+    // ctrl-c sets 'quitting' flag; no SA_RESTART so the timerfd read
+    // returns EINTR instead of waiting out the period
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ctrl_c_handler;
+    sigaction(SIGINT, &sa, nullptr);
 
     gpiod_line_value values_old[2];
     gpiod_line_value values_new[2];
@@ -135,10 +176,45 @@ int main(int argc, char *argv[])
     int r2 = gpiod_line_request_get_values(request, values_old);
     assert(r2 == 0);
 
+    // The timer's first expiration is one period from now, then every
+    // period after that, all on the same absolute grid.
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    assert(timer_fd >= 0);
+
+    uint64_t start_ns = now_ns() + period_ns;
+    itimerspec its;
+    its.it_value.tv_sec = start_ns / 1000000000;
+    its.it_value.tv_nsec = start_ns % 1000000000;
+    its.it_interval.tv_sec = period_ns / 1000000000;
+    its.it_interval.tv_nsec = period_ns % 1000000000;
+    int r3 = timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, nullptr);
+    assert(r3 == 0);
+
+    static histogram<> spacing;     // nsec between samples
+    uint64_t samples = 0;
+    uint64_t missed = 0;            // deadlines with no sample
+    uint64_t last_ns = 0;
+
     while (!quitting) {
 
-        int r3 = gpiod_line_request_get_values(request, values_new);
-        assert(r3 == 0);
+        // Blocks until the next expiration; returns the number of
+        // expirations since the last read.
+        uint64_t expirations;
+        ssize_t n = read(timer_fd, &expirations, sizeof(expirations));
+        if (n < 0 && errno == EINTR)
+            break; // ctrl-c
+        assert(n == sizeof(expirations));
+
+        uint64_t sample_ns = now_ns();
+
+        int r4 = gpiod_line_request_get_values(request, values_new);
+        assert(r4 == 0);
+
+        samples++;
+        missed += expirations - 1;
+        if (last_ns != 0)
+            spacing.record(sample_ns - last_ns);
+        last_ns = sample_ns;
 
         // print changes
         for (unsigned i = 0; i < 2; i++) {
@@ -149,10 +225,16 @@ int main(int argc, char *argv[])
             }
         }
 
-        usleep(1000);
-
     } // while
 
+    close(timer_fd);
+
+    printf("%" PRIu64 " samples, %" PRIu64 " missed deadlines\n", samples, missed);
+    if (spacing.count() > 0)
+        printf("spacing usec: min %.1f p1 %.1f p50 %.1f p99 %.1f max %.1f\n",
+               spacing.min() / 1e3, spacing.percentile(1) / 1e3, spacing.percentile(50) / 1e3,
+               spacing.percentile(99) / 1e3, spacing.max() / 1e3);
+
     gpiod_line_request_release(request);
     request = nullptr;
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+// Line values packed one bit per line, 64 lines to a word.
+//
+// Comparing two samples is then one XOR per 64 lines, and the lines that
+// changed are found by repeatedly taking the lowest set bit of the XOR
+// (count trailing zeros, then clear it). The cost is proportional to the
+// number of words plus the number of changes, not the number of lines,
+// which matters when watching every line of several chips.
+//
+// Word w holds lines 64 * w to 64 * w + 63; bit i of a word is line
+// 64 * w + i. The kernel's line value ioctls use the same layout for the
+// lines of one request (at most 64), so a request's values come back as
+// one word with no unpacking.
+
+static const int line_bits_per_word = 64;
+
+// Words needed for num_lines.
+static inline int line_bits_words(int num_lines)
+{
+    return (num_lines + line_bits_per_word - 1) / line_bits_per_word;
+}
+
+// Mask with the low num_lines bits set (num_lines 0..64).
+static inline uint64_t line_bits_mask(int num_lines)
+{
+    return num_lines >= line_bits_per_word ? ~uint64_t(0)
+                                           : (uint64_t(1) << num_lines) - 1;
+}
+
+static inline int line_bits_get(const uint64_t *bits, int line)
+{
+    return (bits[line / line_bits_per_word] >> (line % line_bits_per_word)) & 1;
+}
+
+static inline void line_bits_set(uint64_t *bits, int line, int value)
+{
+    uint64_t bit = uint64_t(1) << (line % line_bits_per_word);
+    if (value)
+        bits[line / line_bits_per_word] |= bit;
+    else
+        bits[line / line_bits_per_word] &= ~bit;
+}
+
+// Call fn(line, new_value) for each line that differs between old_bits
+// and new_bits, in increasing line order. Returns the number of changes.
+template <typename F>
+static inline int line_bits_changes(const uint64_t *old_bits, const uint64_t *new_bits,
+                                    int num_words, F fn)
+{
+    int changes = 0;
+    for (int w = 0; w < num_words; w++) {
+        uint64_t diff = old_bits[w] ^ new_bits[w];
+        while (diff != 0) {
+            int b = __builtin_ctzll(diff);
+            fn(w * line_bits_per_word + b, int(new_bits[w] >> b) & 1);
+            diff &= diff - 1; // clear lowest set bit
+            changes++;
+        }
+    }
+    return changes;
+}
@@ -1,7 +1,9 @@
 #include <cassert>
 #include <signal.h> // ctrl-c handler
+#include <stdio.h>
 #include <unistd.h> // sleep()
 #include <gpiod.h>
+#include "rt_profile.h"
 
 extern "C" {
 void gpiod_line_config_show(gpiod_line_config*);
@@ -11,6 +13,11 @@ void gpiod_line_request_show(gpiod_line_request*);
 };
 
 // This will configure one pin as output then toggle it repeatedly.
+//
+// Usage: output1_simple [-r] [-p priority] [-c cpu]
+//
+// Any of the options turns on the real-time profile (see rt_profile.h) for
+// the toggle loop; page faults and context switches are reported at exit.
 
 static const char *chip_path = "/dev/gpiochip0";
 
@@ -29,6 +36,16 @@ static void ctrl_c_handler(int notused)
 int main(int argc, char *argv[])
 {
 
+    rt_options rt;
+    rt_options_init(rt);
+
+    for (int i = 1; i < argc; i++) {
+        if (!rt_options_parse(i, argc, argv, rt)) {
+            fprintf(stderr, "usage: %s %s\n", argv[0], rt_options_usage);
+            return 1;
+        }
+    }
+
     // Allocate a new gpiod_line_config structure and initialize it.
     // All userspace, in fact just a malloc and memset.
     gpiod_line_config *line_config = gpiod_line_config_new();
@@ -122,6 +139,12 @@ int main(int argc, char *argv[])
     };
     int code = 0; // 0, 1
 
+    // Everything the loop uses is allocated by now, so this locks it in.
+    if (rt.enabled)
+        rt_profile_apply(rt.priority, rt.cpu);
+
+    rt_usage usage = rt_usage_now();
+
     // ctrl-c sets 'quitting'
     signal(SIGINT, ctrl_c_handler);
 
@@ -140,6 +163,8 @@ int main(int argc, char *argv[])
     // set output low
     gpiod_line_request_set_value(request, gpio_num, code_values[0]);
 
+    rt_usage_print(usage);
+
     // inputs (with no pull) would be more polite
 
     gpiod_line_request_release(request);
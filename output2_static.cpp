@@ -0,0 +1,58 @@
+#include <signal.h> // ctrl-c handler
+#include <unistd.h> // sleep()
+#include <gpiod.h>
+#include "gpiod_static.h"
+
+// Same as output2_simple (two outputs as a two-bit counter), but with the
+// lines described at compile time using gpiod_static.h. The line offsets,
+// initial values and the code table are all constexpr; the loop only
+// indexes a table the compiler built.
+
+static const char *chip_path = "/dev/gpiochip0";
+
+// GPIO23 is lsb, GPIO24 is msb; initial value is code 1 like output2_simple
+static constexpr auto lines = make_line_set(
+    output_line(23, GPIOD_LINE_VALUE_ACTIVE),   // lsb
+    output_line(24, GPIOD_LINE_VALUE_INACTIVE)  // msb
+);
+
+// code_values[code] has the values for lines[] to output 'code'
+static constexpr auto code_values = binary_code_table<lines.size()>();
+
+static_assert(code_values.size() == 4, "two lines make a two-bit counter");
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    static_request<lines.size()> request(chip_path, "output2_static", lines);
+
+    size_t code = 0;
+
+    // ctrl-c sets 'quitting'
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        sleep(1);
+
+        request.set_values(code_values[code]);
+
+        if (++code >= code_values.size())
+            code = 0;
+
+    } // while
+
+    // set outputs low
+    request.set_values(code_values[0]);
+
+    return 0;
+
+} // main
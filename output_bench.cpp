@@ -0,0 +1,238 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <gpiod.h>
+#include "histogram.h"
+
+// How fast can outputs be toggled through libgpiod?
+//
+// For each line count (1, 2, 4, ... up to the number of lines given, at
+// most 32), the first n lines are requested as outputs and toggled as
+// fast as possible for a fixed time, two ways:
+//
+//   set_value   one gpiod_line_request_set_value call per line, as
+//               output1_simple does
+//   set_values  one gpiod_line_request_set_values call for all n lines,
+//               as output2_simple does
+//
+// Reported per test: calls per second, line toggles per second, the
+// latency of each call (p50, p99, max), and the user and system CPU time
+// used. Each call is timed individually, which adds a clock read (tens of
+// nsec) to every call; the rates include it.
+//
+// The lines really are driven, so only give lines that are safe to
+// toggle at high speed.
+//
+// Usage: output_bench [-d seconds] [chip:offset[,offset...]]
+//
+//   defaults: -d 1, /dev/gpiochip0:23,24
+
+static const char *default_lines = "/dev/gpiochip0:23,24";
+
+static const int max_lines = 32;
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+// User and system CPU time used by the process.
+static void cpu_ns(uint64_t &user_ns, uint64_t &sys_ns)
+{
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    user_ns = uint64_t(ru.ru_utime.tv_sec) * 1000000000 + uint64_t(ru.ru_utime.tv_usec) * 1000;
+    sys_ns = uint64_t(ru.ru_stime.tv_sec) * 1000000000 + uint64_t(ru.ru_stime.tv_usec) * 1000;
+}
+
+
+static bool parse_lines(const char *arg, char *chip_path, size_t chip_len,
+                        unsigned int *offsets, int &num_offsets)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || size_t(colon - arg) >= chip_len)
+        return false;
+    memcpy(chip_path, arg, colon - arg);
+    chip_path[colon - arg] = '\0';
+    num_offsets = 0;
+    const char *p = colon + 1;
+    while (*p != '\0' && num_offsets < max_lines) {
+        char *end;
+        offsets[num_offsets++] = strtoul(p, &end, 0);
+        if (end == p)
+            return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return num_offsets > 0 && *p == '\0';
+}
+
+
+static gpiod_line_request *request_outputs(gpiod_chip *chip, const unsigned int *offsets,
+                                           int num_lines)
+{
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+    gpiod_line_settings_set_drive(settings, GPIOD_LINE_DRIVE_PUSH_PULL);
+    gpiod_line_settings_set_output_value(settings, GPIOD_LINE_VALUE_INACTIVE);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r = gpiod_line_config_add_line_settings(line_config, offsets, num_lines, settings);
+    assert(r == 0);
+
+    gpiod_line_settings_free(settings);
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "output_bench");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+
+    gpiod_request_config_free(request_config);
+    gpiod_line_config_free(line_config);
+
+    return request;
+}
+
+
+// Toggle for 'seconds' and print the results. per_line selects set_value
+// (one call per line) or set_values (one call for all).
+static void run_test(gpiod_line_request *request, const unsigned int *offsets, int num_lines,
+                     bool per_line, int seconds)
+{
+    static histogram<> h;
+    h.reset();
+
+    gpiod_line_value values[max_lines];
+    for (int i = 0; i < num_lines; i++)
+        values[i] = GPIOD_LINE_VALUE_INACTIVE;
+    gpiod_line_value value = GPIOD_LINE_VALUE_INACTIVE;
+
+    uint64_t calls = 0;
+    uint64_t user0_ns, sys0_ns;
+    cpu_ns(user0_ns, sys0_ns);
+    uint64_t start_ns = now_ns();
+    uint64_t end_ns = start_ns + uint64_t(seconds) * 1000000000;
+    uint64_t t_ns = start_ns;
+
+    while (t_ns < end_ns) {
+
+        value = value == GPIOD_LINE_VALUE_ACTIVE ? GPIOD_LINE_VALUE_INACTIVE
+                                                 : GPIOD_LINE_VALUE_ACTIVE;
+
+        if (per_line) {
+            for (int i = 0; i < num_lines; i++) {
+                int r = gpiod_line_request_set_value(request, offsets[i], value);
+                assert(r == 0);
+                uint64_t t2_ns = now_ns();
+                h.record(t2_ns - t_ns);
+                t_ns = t2_ns;
+            }
+            calls += num_lines;
+        } else {
+            for (int i = 0; i < num_lines; i++)
+                values[i] = value;
+            int r = gpiod_line_request_set_values(request, values);
+            assert(r == 0);
+            uint64_t t2_ns = now_ns();
+            h.record(t2_ns - t_ns);
+            t_ns = t2_ns;
+            calls++;
+        }
+
+    } // while
+
+    double elapsed = (t_ns - start_ns) / 1e9;
+    uint64_t user1_ns, sys1_ns;
+    cpu_ns(user1_ns, sys1_ns);
+
+    // every call toggles one line (set_value) or all of them (set_values)
+    uint64_t toggles = per_line ? calls : calls * num_lines;
+
+    printf("%5d %-10s %10.0f %12.0f %8.0f %8.0f %9.0f %6.1f%% %6.1f%%\n", num_lines,
+           per_line ? "set_value" : "set_values", calls / elapsed, toggles / elapsed,
+           double(h.percentile(50)), double(h.percentile(99)), double(h.max()),
+           100.0 * (user1_ns - user0_ns) / (t_ns - start_ns),
+           100.0 * (sys1_ns - sys0_ns) / (t_ns - start_ns));
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    int seconds = 1;
+    const char *lines_arg = default_lines;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            seconds = strtol(argv[++i], nullptr, 0);
+        } else if (argv[i][0] != '-') {
+            lines_arg = argv[i];
+        } else {
+            argc = 0; // force usage message
+        }
+    }
+
+    char chip_path[64];
+    unsigned int offsets[max_lines];
+    int num_offsets = 0;
+
+    if (argc == 0 || seconds <= 0 ||
+        !parse_lines(lines_arg, chip_path, sizeof(chip_path), offsets, num_offsets)) {
+        fprintf(stderr, "usage: %s [-d seconds] [chip:offset[,offset...]]\n", argv[0]);
+        return 1;
+    }
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    if (chip == nullptr) {
+        fprintf(stderr, "%s: can't open %s: %s\n", argv[0], chip_path, strerror(errno));
+        return 1;
+    }
+
+    printf("%d sec per test; latency in nsec; cpu as %% of elapsed\n", seconds);
+    printf("%5s %-10s %10s %12s %8s %8s %9s %7s %7s\n", "lines", "call", "calls/s",
+           "toggles/s", "p50", "p99", "max", "user", "sys");
+
+    // 1, 2, 4, ... and the full count if it isn't a power of 2
+    for (int n = 1; ; n = n * 2 < num_offsets ? n * 2 : num_offsets) {
+
+        gpiod_line_request *request = request_outputs(chip, offsets, n);
+        if (request == nullptr) {
+            fprintf(stderr, "%s: can't request %d lines: %s\n", argv[0], n, strerror(errno));
+            return 1;
+        }
+
+        run_test(request, offsets, n, true, seconds);
+        run_test(request, offsets, n, false, seconds);
+
+        // leave them low
+        gpiod_line_value values[max_lines];
+        for (int i = 0; i < n; i++)
+            values[i] = GPIOD_LINE_VALUE_INACTIVE;
+        gpiod_line_request_set_values(request, values);
+
+        gpiod_line_request_release(request);
+
+        if (n == num_offsets)
+            break;
+    }
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    return 0;
+
+} // main
@@ -0,0 +1,336 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <time.h>
+#include <gpiod.h>
+#include "histogram.h"
+#include "rt_profile.h"
+
+// Software PWM on many lines from one thread and one request.
+//
+// Each channel has a frequency and a duty cycle. The engine keeps the
+// absolute time of each channel's next edge; each pass it finds the
+// earliest, sleeps until then with clock_nanosleep(TIMER_ABSTIME), and
+// applies every edge that is due (within the merge window) with a single
+// gpiod_line_request_set_values call. Deadlines are computed from the
+// start time, never from when the last edge actually happened, so late
+// edges don't make the waveform drift.
+//
+// Channels with related frequencies share edge times (all of them rise
+// together at the start of each common period), so the number of calls
+// is usually much less than the number of edges.
+//
+// Usage: output_pwm [-g chip] [-m merge_us] [-r] [-p priority] [-c cpu]
+//                   offset:hz:duty% ...
+//
+//   defaults: -g /dev/gpiochip0, -m 2, channels 23:50:25 24:50:75
+//
+// Edge timing error (how late each set_values call returned relative to
+// the deadline it was for) is reported every few seconds and at exit. The
+// real-time profile options (rt_profile.h) make a big difference here.
+
+static const char *default_chip_path = "/dev/gpiochip0";
+
+static const int max_channels = 64;
+
+static const uint64_t report_ns = 5000000000ULL; // report interval
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+struct pwm_channel {
+    unsigned int offset;
+    uint64_t period_ns;
+    uint64_t on_ns;         // high time per period (0 or period: no edges)
+    uint64_t period_start_ns;
+    uint64_t next_ns;       // next edge, absolute
+    bool high;              // current level
+};
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void sleep_until(uint64_t t_ns)
+{
+    timespec ts;
+    ts.tv_sec = t_ns / 1000000000;
+    ts.tv_nsec = t_ns % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr); // EINTR is fine
+}
+
+
+static bool parse_channel(const char *arg, pwm_channel &ch)
+{
+    char *end;
+    unsigned long offset = strtoul(arg, &end, 0);
+    if (end == arg || *end != ':')
+        return false;
+    const char *p = end + 1;
+    double hz = strtod(p, &end);
+    if (end == p || *end != ':' || hz <= 0.0)
+        return false;
+    p = end + 1;
+    double duty = strtod(p, &end);
+    if (end == p || (*end != '\0' && strcmp(end, "%") != 0) || duty < 0.0 || duty > 100.0)
+        return false;
+    ch.offset = offset;
+    ch.period_ns = uint64_t(1e9 / hz + 0.5);
+    ch.on_ns = uint64_t(ch.period_ns * duty / 100.0 + 0.5);
+    return ch.period_ns > 0;
+}
+
+
+// Start all channels at t0: high (unless duty is 0), next edge is the
+// fall (or none, for 0% and 100%).
+static void start(pwm_channel &ch, uint64_t t0_ns)
+{
+    ch.period_start_ns = t0_ns;
+    if (ch.on_ns == 0) {
+        ch.high = false;
+        ch.next_ns = UINT64_MAX;
+    } else if (ch.on_ns >= ch.period_ns) {
+        ch.high = true;
+        ch.next_ns = UINT64_MAX;
+    } else {
+        ch.high = true;
+        ch.next_ns = t0_ns + ch.on_ns;
+    }
+}
+
+
+// Apply the channel's next edge to its level and schedule the one after.
+static void step(pwm_channel &ch)
+{
+    if (ch.high) {
+        // falling now; next is the rise at the start of the next period
+        ch.high = false;
+        ch.period_start_ns += ch.period_ns;
+        ch.next_ns = ch.period_start_ns;
+    } else {
+        ch.high = true;
+        ch.next_ns = ch.period_start_ns + ch.on_ns;
+    }
+}
+
+
+static void print_report(const char *label, const histogram<> &err, uint64_t edges,
+                         uint64_t calls, uint64_t overruns)
+{
+    if (err.count() == 0) {
+        printf("%s: no edges\n", label);
+        return;
+    }
+    printf("%s: %" PRIu64 " edges in %" PRIu64 " calls (%.2f per call), late usec p50 %.1f"
+           " p99 %.1f max %.1f, %" PRIu64 " overruns\n", label, edges, calls,
+           double(edges) / calls, err.percentile(50) / 1e3, err.percentile(99) / 1e3,
+           err.max() / 1e3, overruns);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    const char *chip_path = default_chip_path;
+    long merge_us = 2;
+    rt_options rt;
+    rt_options_init(rt);
+
+    static pwm_channel channels[max_channels];
+    int num_channels = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            chip_path = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            merge_us = strtol(argv[++i], nullptr, 0);
+        } else if (rt_options_parse(i, argc, argv, rt)) {
+            // handled
+        } else if (argv[i][0] != '-' && num_channels < max_channels &&
+                   parse_channel(argv[i], channels[num_channels])) {
+            num_channels++;
+        } else {
+            fprintf(stderr, "usage: %s [-g chip] [-m merge_us] %s offset:hz:duty%% ...\n",
+                    argv[0], rt_options_usage);
+            return 1;
+        }
+    }
+
+    if (num_channels == 0) {
+        parse_channel("23:50:25", channels[num_channels++]);
+        parse_channel("24:50:75", channels[num_channels++]);
+    }
+
+    const uint64_t merge_ns = merge_us > 0 ? uint64_t(merge_us) * 1000 : 0;
+
+    unsigned int offsets[max_channels];
+    for (int c = 0; c < num_channels; c++)
+        offsets[c] = channels[c].offset;
+
+    // One request for all channels, outputs starting low.
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+    gpiod_line_settings_set_drive(settings, GPIOD_LINE_DRIVE_PUSH_PULL);
+    gpiod_line_settings_set_output_value(settings, GPIOD_LINE_VALUE_INACTIVE);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, num_channels, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    if (chip == nullptr) {
+        fprintf(stderr, "%s: can't open %s: %s\n", argv[0], chip_path, strerror(errno));
+        return 1;
+    }
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "output_pwm");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    if (request == nullptr) {
+        fprintf(stderr, "%s: can't request lines: %s\n", argv[0], strerror(errno));
+        return 1;
+    }
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    for (int c = 0; c < num_channels; c++)
+        printf("pin %u: period %" PRIu64 " usec, high %" PRIu64 " usec\n", channels[c].offset,
+               channels[c].period_ns / 1000, channels[c].on_ns / 1000);
+
+    // Values for set_values, same order as offsets[].
+    gpiod_line_value values[max_channels];
+
+    static histogram<> err_interval, err_total;
+    uint64_t edges_interval = 0, edges_total = 0;
+    uint64_t calls_interval = 0, calls_total = 0;
+    uint64_t overruns_interval = 0, overruns_total = 0;
+
+    if (rt.enabled)
+        rt_profile_apply(rt.priority, rt.cpu);
+
+    // Start a little in the future so the first edge is on time.
+    uint64_t t0_ns = now_ns() + 1000000;
+    for (int c = 0; c < num_channels; c++) {
+        start(channels[c], t0_ns);
+        values[c] = channels[c].high ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE;
+    }
+    sleep_until(t0_ns);
+    int r2 = gpiod_line_request_set_values(request, values);
+    assert(r2 == 0);
+
+    uint64_t next_report_ns = t0_ns + report_ns;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        // Earliest edge of any channel.
+        uint64_t deadline_ns = UINT64_MAX;
+        for (int c = 0; c < num_channels; c++)
+            if (channels[c].next_ns < deadline_ns)
+                deadline_ns = channels[c].next_ns;
+
+        if (deadline_ns == UINT64_MAX) {
+            // all channels constant: nothing to do but wait for ctrl-c
+            sleep_until(now_ns() + 100000000);
+            continue;
+        }
+
+        // Wake at the report time if it comes first.
+        if (deadline_ns > next_report_ns) {
+            sleep_until(next_report_ns);
+        } else {
+            sleep_until(deadline_ns);
+
+            // Apply every edge due by the end of the merge window.
+            uint64_t merge_end_ns = deadline_ns + merge_ns;
+            int edges = 0;
+            for (int c = 0; c < num_channels; c++) {
+                pwm_channel &ch = channels[c];
+                if (ch.next_ns <= merge_end_ns) {
+                    step(ch);
+                    values[c] = ch.high ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE;
+                    edges++;
+                }
+            }
+
+            int r3 = gpiod_line_request_set_values(request, values);
+            assert(r3 == 0);
+
+            uint64_t done_ns = now_ns();
+            err_interval.record(done_ns > deadline_ns ? done_ns - deadline_ns : 0);
+            edges_interval += edges;
+            calls_interval++;
+
+            // Overrun: the next edge is already due; it will go out late
+            // but on the original schedule.
+            uint64_t next_ns = UINT64_MAX;
+            for (int c = 0; c < num_channels; c++)
+                if (channels[c].next_ns < next_ns)
+                    next_ns = channels[c].next_ns;
+            if (next_ns < done_ns)
+                overruns_interval++;
+        }
+
+        if (now_ns() >= next_report_ns) {
+            print_report("last", err_interval, edges_interval, calls_interval,
+                         overruns_interval);
+            err_total.add(err_interval);
+            err_interval.reset();
+            edges_total += edges_interval;
+            calls_total += calls_interval;
+            overruns_total += overruns_interval;
+            edges_interval = calls_interval = overruns_interval = 0;
+            next_report_ns += report_ns;
+        }
+
+    } // while
+
+    err_total.add(err_interval);
+    print_report("total", err_total, edges_total + edges_interval, calls_total + calls_interval,
+                 overruns_total + overruns_interval);
+
+    // leave everything low
+    for (int c = 0; c < num_channels; c++)
+        values[c] = GPIOD_LINE_VALUE_INACTIVE;
+    gpiod_line_request_set_values(request, values);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    return 0;
+
+} // main
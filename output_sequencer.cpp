@@ -0,0 +1,388 @@
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <linux/gpio.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <gpiod.h>
+#include "histogram.h"
+#include "line_bits.h"
+#include "rt_profile.h"
+
+// Play a table of (line values, duration) steps on a set of outputs with
+// precise timing; output2_simple's two-bit counter generalized.
+//
+// The table is read from a file before anything is played and compiled
+// into one contiguous array. Each entry holds the packed values (bit i is
+// the i'th line, see line_bits.h) and the step's start time as an offset
+// from the start of the table. Playing a step is then one array read, one
+// clock_nanosleep to an absolute deadline (table start + offset, so
+// errors don't accumulate from step to step or loop to loop) and one
+// GPIO_V2_LINE_SET_VALUES_IOCTL. Nothing is parsed or allocated while
+// playing.
+//
+// Table file: one step per line, '#' starts a comment.
+//
+//   <values> <duration_us>
+//
+// where values has one '0' or '1' per output line, in the order the lines
+// were given. Without a file, the table is output2_simple's counter
+// (00, 10, 01, 11 with the first line as lsb), one second per step.
+//
+// Usage: output_sequencer [-n loops] [-r] [-p priority] [-c cpu]
+//                         [-l chip:offset[,offset...]] [table]
+//
+//   -n   0 loops forever (default), 1 is one-shot
+//   -l   default /dev/gpiochip0:23,24
+//
+// How late each step went out is recorded; the distribution over all
+// steps, and the mean and worst lateness of each step of the table, are
+// printed at the end.
+
+static const char *default_lines = "/dev/gpiochip0:23,24";
+
+static const int max_lines = line_bits_per_word;
+static const int max_steps = 65536;
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+// One compiled step.
+struct seq_step {
+    uint64_t bits;          // line values, packed
+    uint64_t start_ns;      // from the start of the table
+};
+
+
+// Per-step lateness, kept apart from seq_step so the array the player
+// reads stays small.
+struct step_stats {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void sleep_until(uint64_t t_ns)
+{
+    timespec ts;
+    ts.tv_sec = t_ns / 1000000000;
+    ts.tv_nsec = t_ns % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr); // EINTR is fine
+}
+
+
+static bool parse_lines(const char *arg, char *chip_path, size_t chip_len,
+                        unsigned int *offsets, int &num_offsets)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || size_t(colon - arg) >= chip_len)
+        return false;
+    memcpy(chip_path, arg, colon - arg);
+    chip_path[colon - arg] = '\0';
+    num_offsets = 0;
+    const char *p = colon + 1;
+    while (*p != '\0' && num_offsets < max_lines) {
+        char *end;
+        offsets[num_offsets++] = strtoul(p, &end, 0);
+        if (end == p)
+            return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return num_offsets > 0 && *p == '\0';
+}
+
+
+// Compile one "<values> <duration_us>" line. Returns false on a syntax
+// error. Blank and comment-only lines set is_step false.
+static bool parse_step(char *text, int num_lines, uint64_t &bits, uint64_t &duration_ns,
+                       bool &is_step)
+{
+    char *hash = strchr(text, '#');
+    if (hash != nullptr)
+        *hash = '\0';
+
+    char *p = text;
+    while (isspace((unsigned char)*p))
+        p++;
+    is_step = *p != '\0';
+    if (!is_step)
+        return true;
+
+    bits = 0;
+    int n = 0;
+    for (; *p == '0' || *p == '1'; p++, n++) {
+        if (n >= num_lines)
+            return false;
+        line_bits_set(&bits, n, *p == '1');
+    }
+    if (n != num_lines || !isspace((unsigned char)*p))
+        return false;
+
+    char *end;
+    unsigned long long us = strtoull(p, &end, 0);
+    while (isspace((unsigned char)*end))
+        end++;
+    if (end == p || *end != '\0' || us == 0)
+        return false;
+    duration_ns = uint64_t(us) * 1000;
+    return true;
+}
+
+
+// Read and compile a table file; returns the number of steps, or -1.
+static int load_table(const char *path, int num_lines, seq_step *steps, uint64_t &length_ns)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "can't open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int num_steps = 0;
+    length_ns = 0;
+    char text[256];
+    int line_num = 0;
+
+    while (fgets(text, sizeof(text), f) != nullptr) {
+        line_num++;
+        uint64_t bits, duration_ns;
+        bool is_step;
+        if (!parse_step(text, num_lines, bits, duration_ns, is_step)) {
+            fprintf(stderr, "%s:%d: expected %d values (0/1) and a duration in usec\n",
+                    path, line_num, num_lines);
+            fclose(f);
+            return -1;
+        }
+        if (!is_step)
+            continue;
+        if (num_steps == max_steps) {
+            fprintf(stderr, "%s: more than %d steps\n", path, max_steps);
+            fclose(f);
+            return -1;
+        }
+        steps[num_steps].bits = bits;
+        steps[num_steps].start_ns = length_ns;
+        num_steps++;
+        length_ns += duration_ns;
+    }
+
+    fclose(f);
+    return num_steps;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    long loops = 0;
+    const char *lines_arg = default_lines;
+    const char *table_path = nullptr;
+    rt_options rt;
+    rt_options_init(rt);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            loops = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            lines_arg = argv[++i];
+        } else if (rt_options_parse(i, argc, argv, rt)) {
+            // handled
+        } else if (argv[i][0] != '-' && table_path == nullptr) {
+            table_path = argv[i];
+        } else {
+            argc = 0; // force usage message
+        }
+    }
+
+    char chip_path[64];
+    unsigned int offsets[max_lines];
+    int num_lines = 0;
+
+    if (argc == 0 || loops < 0 ||
+        !parse_lines(lines_arg, chip_path, sizeof(chip_path), offsets, num_lines)) {
+        fprintf(stderr, "usage: %s [-n loops] %s [-l chip:offset[,offset...]] [table]\n",
+                argv[0], rt_options_usage);
+        return 1;
+    }
+
+    static seq_step steps[max_steps];
+    static step_stats stats[max_steps];
+    int num_steps;
+    uint64_t length_ns;
+
+    if (table_path != nullptr) {
+        num_steps = load_table(table_path, num_lines, steps, length_ns);
+        if (num_steps < 0)
+            return 1;
+        if (num_steps == 0) {
+            fprintf(stderr, "%s: no steps in %s\n", argv[0], table_path);
+            return 1;
+        }
+    } else {
+        // output2_simple's counter, on however many lines there are
+        num_steps = 0;
+        length_ns = 0;
+        int codes = num_lines < 8 ? 1 << num_lines : 256;
+        for (int code = 0; code < codes; code++) {
+            steps[num_steps].bits = uint64_t(code);
+            steps[num_steps].start_ns = length_ns;
+            num_steps++;
+            length_ns += 1000000000;
+        }
+    }
+
+    printf("%d steps, %.6f sec per pass, %s\n", num_steps, length_ns / 1e9,
+           loops == 0 ? "looping" : loops == 1 ? "one-shot" : "looping a fixed number of times");
+
+    // Outputs start at the first step's values.
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+    gpiod_line_settings_set_drive(settings, GPIOD_LINE_DRIVE_PUSH_PULL);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, num_lines, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_line_value init_values[max_lines];
+    for (int i = 0; i < num_lines; i++)
+        init_values[i] = line_bits_get(&steps[0].bits, i) ? GPIOD_LINE_VALUE_ACTIVE
+                                                          : GPIOD_LINE_VALUE_INACTIVE;
+    int r2 = gpiod_line_config_set_output_values(line_config, init_values, num_lines);
+    assert(r2 == 0);
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    if (chip == nullptr) {
+        fprintf(stderr, "%s: can't open %s: %s\n", argv[0], chip_path, strerror(errno));
+        return 1;
+    }
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "output_sequencer");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    if (request == nullptr) {
+        fprintf(stderr, "%s: can't request lines: %s\n", argv[0], strerror(errno));
+        return 1;
+    }
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    // Values are written with the ioctl directly, from the packed bits.
+    gpio_v2_line_values values;
+    values.mask = line_bits_mask(num_lines);
+    const int fd = gpiod_line_request_get_fd(request);
+
+    static histogram<> late;
+
+    if (rt.enabled)
+        rt_profile_apply(rt.priority, rt.cpu);
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    // Start a little in the future so the first step is on time.
+    uint64_t pass_start_ns = now_ns() + 1000000;
+    long pass = 0;
+
+    while (!quitting && (loops == 0 || pass < loops)) {
+
+        for (int s = 0; s < num_steps && !quitting; s++) {
+
+            const seq_step &step = steps[s];
+            uint64_t deadline_ns = pass_start_ns + step.start_ns;
+
+            sleep_until(deadline_ns);
+
+            values.bits = step.bits;
+            int r3 = ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+            assert(r3 == 0);
+
+            uint64_t t_ns = now_ns();
+            uint64_t late_ns = t_ns > deadline_ns ? t_ns - deadline_ns : 0;
+            late.record(late_ns);
+            step_stats &st = stats[s];
+            st.count++;
+            st.total_ns += late_ns;
+            if (late_ns > st.max_ns)
+                st.max_ns = late_ns;
+        }
+
+        if (quitting)
+            break; // partial pass isn't counted
+
+        pass_start_ns += length_ns;
+        pass++;
+
+    } // while
+
+    // In one-shot (or counted) mode, hold the last step's values until
+    // its duration is up, so it is as long as the others.
+    if (!quitting)
+        sleep_until(pass_start_ns);
+
+    printf("%ld passes, %" PRIu64 " steps played\n", pass, late.count());
+    if (late.count() > 0) {
+        printf("late usec: p50 %.1f p99 %.1f p99.9 %.1f max %.1f\n", late.percentile(50) / 1e3,
+               late.percentile(99) / 1e3, late.percentile(99.9) / 1e3, late.max() / 1e3);
+
+        // Per step, for small tables; otherwise just the worst one.
+        int worst = 0;
+        for (int s = 0; s < num_steps; s++) {
+            if (stats[s].max_ns > stats[worst].max_ns)
+                worst = s;
+            if (num_steps <= 32 && stats[s].count > 0)
+                printf("  step %3d: late usec mean %.1f max %.1f\n", s,
+                       double(stats[s].total_ns) / stats[s].count / 1e3, stats[s].max_ns / 1e3);
+        }
+        if (num_steps > 32)
+            printf("  worst step %d: late usec mean %.1f max %.1f\n", worst,
+                   double(stats[worst].total_ns) / stats[worst].count / 1e3,
+                   stats[worst].max_ns / 1e3);
+    }
+
+    // set outputs low
+    values.bits = 0;
+    ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    return 0;
+
+} // main
@@ -0,0 +1,315 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <gpiod.h>
+#include "histogram.h"
+#include "line_bits.h"
+#include "pattern.h"
+#include "rt_profile.h"
+
+// Play a pattern file (see pattern.h, and pattern_gen to make one) on a
+// set of outputs, streaming it from disk.
+//
+// The file is mapped, not read, and only a window around the play
+// position is mapped and kept in memory (pattern_reader::prefetch), so
+// files much bigger than RAM (or than a 32-bit address space) play in
+// constant memory. Each record's values are set
+// with gpiod_line_request_set_values at its scheduled time, an absolute
+// deadline from the start of playback.
+//
+// Each record is read before sleeping until its deadline, so if its page
+// has to come from disk that happens in the slack before the deadline
+// rather than after it. Reported at the end (and every few seconds):
+//
+//   late       how late each set_values call finished (histogram)
+//   underruns  steps that finished after the next step was already due,
+//              i.e. a step that effectively didn't happen
+//   misses     pages that weren't resident when playback reached them
+//              (prefetch fell behind the disk)
+//
+// plus major page faults and peak resident memory for the run.
+//
+// Usage: output_stream [-l chip:offset[,offset...]] [-w window_mb]
+//                      [-r] [-p priority] [-c cpu] file
+//
+// Lines default to the ones in the file's header. The real-time profile
+// (rt_profile.h) locks memory with MCL_FUTURE, which would pull the whole
+// file in, so with this program it locks only what is mapped before the
+// file is.
+
+static const uint64_t report_ns = 5000000000ULL; // report interval
+
+static bool quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void sleep_until(uint64_t t_ns)
+{
+    timespec ts;
+    ts.tv_sec = t_ns / 1000000000;
+    ts.tv_nsec = t_ns % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr); // EINTR is fine
+}
+
+
+static bool parse_lines(const char *arg, char *chip_path, size_t chip_len,
+                        unsigned int *offsets, int &num_offsets)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || size_t(colon - arg) >= chip_len)
+        return false;
+    memcpy(chip_path, arg, colon - arg);
+    chip_path[colon - arg] = '\0';
+    num_offsets = 0;
+    const char *p = colon + 1;
+    while (*p != '\0' && num_offsets < pattern_max_lines) {
+        char *end;
+        offsets[num_offsets++] = strtoul(p, &end, 0);
+        if (end == p)
+            return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return num_offsets > 0 && *p == '\0';
+}
+
+
+static void print_report(const char *label, uint64_t played, uint64_t total,
+                         const histogram<> &late, uint64_t underruns, uint64_t misses)
+{
+    printf("%s: %" PRIu64 "/%" PRIu64 " records", label, played, total);
+    if (late.count() > 0)
+        printf(", late usec p50 %.1f p99 %.1f max %.1f", late.percentile(50) / 1e3,
+               late.percentile(99) / 1e3, late.max() / 1e3);
+    printf(", %" PRIu64 " underruns, %" PRIu64 " misses\n", underruns, misses);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    const char *lines_arg = nullptr;
+    long window_mb = 64;
+    const char *path = nullptr;
+    rt_options rt;
+    rt_options_init(rt);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            lines_arg = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            window_mb = strtol(argv[++i], nullptr, 0);
+        } else if (rt_options_parse(i, argc, argv, rt)) {
+            // handled
+        } else if (argv[i][0] != '-' && path == nullptr) {
+            path = argv[i];
+        } else {
+            argc = 0; // force usage message
+        }
+    }
+
+    if (argc == 0 || path == nullptr || window_mb <= 0) {
+        fprintf(stderr, "usage: %s [-l chip:offset[,offset...]] [-w window_mb] %s file\n",
+                argv[0], rt_options_usage);
+        return 1;
+    }
+
+    // Lock what's mapped so far (code, stack, libraries) before the file
+    // is mapped; see above. Calling mlockall again without MCL_FUTURE
+    // turns MCL_FUTURE off.
+    if (rt.enabled) {
+        rt_profile_apply(rt.priority, rt.cpu);
+        if (mlockall(MCL_CURRENT) != 0)
+            fprintf(stderr, "rt: mlockall: %s\n", strerror(errno));
+    }
+
+    pattern_reader reader;
+    size_t window = size_t(window_mb) * 1024 * 1024;
+    errno = 0;
+    if (!reader.open(path, window, window / 16)) {
+        fprintf(stderr, "%s: can't open pattern %s: %s\n", argv[0], path,
+                errno ? strerror(errno) : "bad header");
+        return 1;
+    }
+
+    const pattern_header *hdr = reader.header();
+    const uint64_t num_records = reader.count();
+
+    char chip_path[64];
+    unsigned int offsets[pattern_max_lines];
+    int num_lines;
+
+    if (lines_arg != nullptr) {
+        if (!parse_lines(lines_arg, chip_path, sizeof(chip_path), offsets, num_lines) ||
+            uint32_t(num_lines) != hdr->num_offsets) {
+            fprintf(stderr, "%s: need %u lines as chip:offset,...\n", argv[0],
+                    hdr->num_offsets);
+            return 1;
+        }
+    } else {
+        memcpy(chip_path, hdr->chip_path, sizeof(chip_path));
+        chip_path[sizeof(chip_path) - 1] = '\0';
+        num_lines = hdr->num_offsets;
+        for (int i = 0; i < num_lines; i++)
+            offsets[i] = hdr->offsets[i];
+    }
+
+    pattern_record first, last;
+    if (num_lines == 0 || !reader.read_record(0, first) ||
+        !reader.read_record(num_records - 1, last)) {
+        fprintf(stderr, "%s: empty pattern\n", argv[0]);
+        return 1;
+    }
+
+    printf("%s: %" PRIu64 " records, %d lines, %.3f sec\n", path, num_records, num_lines,
+           last.time_ns / 1e9);
+
+    // Outputs, starting at the first record's values.
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    assert(settings != nullptr);
+
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+    gpiod_line_settings_set_drive(settings, GPIOD_LINE_DRIVE_PUSH_PULL);
+
+    gpiod_line_config *line_config = gpiod_line_config_new();
+    assert(line_config != nullptr);
+
+    int r1 = gpiod_line_config_add_line_settings(line_config, offsets, num_lines, settings);
+    assert(r1 == 0);
+
+    gpiod_line_settings_free(settings);
+    settings = nullptr;
+
+    gpiod_line_value values[pattern_max_lines];
+    for (int l = 0; l < num_lines; l++)
+        values[l] = line_bits_get(&first.bits, l) ? GPIOD_LINE_VALUE_ACTIVE
+                                                       : GPIOD_LINE_VALUE_INACTIVE;
+    int r2 = gpiod_line_config_set_output_values(line_config, values, num_lines);
+    assert(r2 == 0);
+
+    gpiod_chip *chip = gpiod_chip_open(chip_path);
+    if (chip == nullptr) {
+        fprintf(stderr, "%s: can't open %s: %s\n", argv[0], chip_path, strerror(errno));
+        return 1;
+    }
+
+    gpiod_request_config *request_config = gpiod_request_config_new();
+    assert(request_config != nullptr);
+
+    gpiod_request_config_set_consumer(request_config, "output_stream");
+
+    gpiod_line_request *request = gpiod_chip_request_lines(chip, request_config, line_config);
+    if (request == nullptr) {
+        fprintf(stderr, "%s: can't request lines: %s\n", argv[0], strerror(errno));
+        return 1;
+    }
+
+    gpiod_request_config_free(request_config);
+    request_config = nullptr;
+
+    gpiod_line_config_free(line_config);
+    line_config = nullptr;
+
+    gpiod_chip_close(chip);
+    chip = nullptr;
+
+    static histogram<> late_interval, late_total;
+    uint64_t underruns = 0, misses = 0;
+    uint64_t underruns_interval = 0, misses_interval = 0;
+
+    rt_usage usage = rt_usage_now();
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    // Start a little in the future so the first record is on time.
+    const uint64_t t0_ns = now_ns() + 10000000;
+    uint64_t next_report_ns = t0_ns + report_ns;
+    uint64_t last_done_ns = 0;
+    uint64_t i;
+
+    for (i = 0; i < num_records && !quitting; i++) {
+
+        reader.prefetch(i);
+
+        // Entering a new page: was it there in time? (Checked before
+        // anything on the page is touched.)
+        if (reader.first_on_page(i) && !reader.resident(i))
+            misses_interval++;
+
+        // Touch the record now (may fault), then wait for its time.
+        const pattern_record rec = reader.record(i);
+        uint64_t deadline_ns = t0_ns + rec.time_ns;
+
+        // The previous step ended up with no time at all.
+        if (last_done_ns > deadline_ns)
+            underruns_interval++;
+
+        sleep_until(deadline_ns);
+
+        for (int l = 0; l < num_lines; l++)
+            values[l] = line_bits_get(&rec.bits, l) ? GPIOD_LINE_VALUE_ACTIVE
+                                                    : GPIOD_LINE_VALUE_INACTIVE;
+        int r3 = gpiod_line_request_set_values(request, values);
+        assert(r3 == 0);
+
+        uint64_t done_ns = now_ns();
+        late_interval.record(done_ns > deadline_ns ? done_ns - deadline_ns : 0);
+        last_done_ns = done_ns;
+
+        if (done_ns >= next_report_ns) {
+            print_report("last", i + 1, num_records, late_interval, underruns_interval,
+                         misses_interval);
+            late_total.add(late_interval);
+            late_interval.reset();
+            underruns += underruns_interval;
+            misses += misses_interval;
+            underruns_interval = misses_interval = 0;
+            next_report_ns += report_ns;
+        }
+
+    } // for
+
+    late_total.add(late_interval);
+    underruns += underruns_interval;
+    misses += misses_interval;
+    print_report("total", i, num_records, late_total, underruns, misses);
+
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("peak resident %ld MB, ", ru.ru_maxrss / 1024);
+    rt_usage_print(usage);
+
+    // set outputs low
+    for (int l = 0; l < num_lines; l++)
+        values[l] = GPIOD_LINE_VALUE_INACTIVE;
+    gpiod_line_request_set_values(request, values);
+
+    gpiod_line_request_release(request);
+    request = nullptr;
+
+    reader.close();
+
+    return 0;
+
+} // main
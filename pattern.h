@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary pattern file for output playback (output_stream).
+//
+// The file is a pattern_header followed by fixed-size pattern_records,
+// each giving the values of all lines (packed, bit i is offsets[i], as in
+// line_bits.h) and the time to output them, relative to the start of
+// playback. Records are in time order. As with capture files, the header
+// says which chip and lines the pattern was made for and all fields are
+// little-endian (native on the Pi).
+//
+// Files can be much bigger than RAM, and than a 32-bit address space.
+// The reader maps only a window of the file around the play position and
+// slides it along one chunk at a time: pages ahead are requested with
+// MADV_WILLNEED, and pages behind are unmapped (and dropped from the page
+// cache with POSIX_FADV_DONTNEED). Offsets are 64-bit throughout; on
+// 32-bit systems this needs _FILE_OFFSET_BITS=64 (set in CMakeLists.txt),
+// without which open and fstat fail on files over 2 GB.
+
+static const char pattern_magic[8] = { 'G', 'P', 'I', 'O', 'P', 'A', 'T', '1' };
+static const uint32_t pattern_version = 1;
+static const int pattern_max_lines = 64;
+
+struct pattern_header {
+    char magic[8];              // pattern_magic
+    uint32_t version;           // pattern_version
+    uint32_t header_size;       // sizeof(pattern_header)
+    uint32_t record_size;       // sizeof(pattern_record)
+    uint32_t num_offsets;       // valid entries in offsets[]
+    uint64_t record_count;
+    char chip_path[64];
+    uint32_t offsets[pattern_max_lines];
+};
+
+struct pattern_record {
+    uint64_t time_ns;           // from start of playback
+    uint64_t bits;              // line values
+};
+
+static_assert(sizeof(pattern_record) == 16, "pattern_record must be 16 bytes");
+static_assert(sizeof(off_t) == 8, "pattern files need 64-bit file offsets"
+              " (build with -D_FILE_OFFSET_BITS=64)");
+static_assert(sizeof(pattern_header) % sizeof(pattern_record) == 0,
+              "records must stay aligned after the header");
+
+
+// Sequential writer. Usage: open(), fill in header() except the fields
+// open() sets, append() records, close(). Uses stdio; pattern files are
+// made ahead of time, so there's no need for anything faster.
+class pattern_writer
+{
+public:
+
+    pattern_writer() : _f(nullptr), _count(0) { }
+
+    ~pattern_writer() { close(); }
+
+    bool open(const char *path)
+    {
+        _f = fopen(path, "wb");
+        if (_f == nullptr)
+            return false;
+        setvbuf(_f, nullptr, _IOFBF, 1024 * 1024);
+        memset(&_hdr, 0, sizeof(_hdr));
+        memcpy(_hdr.magic, pattern_magic, sizeof(_hdr.magic));
+        _hdr.version = pattern_version;
+        _hdr.header_size = sizeof(pattern_header);
+        _hdr.record_size = sizeof(pattern_record);
+        // placeholder; rewritten with the count at close
+        return fwrite(&_hdr, sizeof(_hdr), 1, _f) == 1;
+    }
+
+    pattern_header *header() { return &_hdr; }
+
+    bool append(const pattern_record &rec)
+    {
+        if (fwrite(&rec, sizeof(rec), 1, _f) != 1)
+            return false;
+        _count++;
+        return true;
+    }
+
+    uint64_t count() const { return _count; }
+
+    // Returns false if anything failed to make it to the file.
+    bool close()
+    {
+        if (_f == nullptr)
+            return true;
+        _hdr.record_count = _count;
+        bool ok = fseek(_f, 0, SEEK_SET) == 0 && fwrite(&_hdr, sizeof(_hdr), 1, _f) == 1;
+        ok = fclose(_f) == 0 && ok;
+        _f = nullptr;
+        return ok;
+    }
+
+private:
+
+    FILE *_f;
+    pattern_header _hdr;
+    uint64_t _count;
+
+}; // class pattern_writer
+
+
+// Streaming read-only view of a pattern file. Call prefetch(i) as record
+// i is reached, then record(i); prefetch manages the mapped window.
+class pattern_reader
+{
+public:
+
+    pattern_reader() : _fd(-1), _map(nullptr), _map_len(0), _count(0) { }
+
+    ~pattern_reader() { close(); }
+
+    // window is how much to keep mapped and resident ahead of the play
+    // position, and chunk how often (in bytes played) to move it.
+    bool open(const char *path, size_t window = 64 * 1024 * 1024,
+              size_t chunk = 4 * 1024 * 1024)
+    {
+        _page = sysconf(_SC_PAGESIZE);
+        _chunk = (chunk + _page - 1) / _page * _page;
+        _window = window < _chunk ? _chunk : window;
+        _fd = ::open(path, O_RDONLY);
+        if (_fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(_fd, &st) != 0 ||
+            pread(_fd, &_hdr, sizeof(_hdr), 0) != ssize_t(sizeof(_hdr))) {
+            close();
+            return false;
+        }
+        if (memcmp(_hdr.magic, pattern_magic, sizeof(_hdr.magic)) != 0 ||
+            _hdr.version != pattern_version ||
+            _hdr.header_size != sizeof(pattern_header) ||
+            _hdr.record_size != sizeof(pattern_record) ||
+            _hdr.num_offsets > pattern_max_lines) {
+            close();
+            return false;
+        }
+        _file_size = st.st_size;
+        _count = (_file_size - sizeof(pattern_header)) / sizeof(pattern_record);
+        if (_hdr.record_count < _count)
+            _count = _hdr.record_count;
+        if (!map(0)) {
+            close();
+            return false;
+        }
+        // Sequential read-ahead on faults, and the first window now.
+        madvise(_map, _map_len, MADV_WILLNEED);
+        return true;
+    }
+
+    void close()
+    {
+        if (_map != nullptr)
+            munmap(_map, _map_len);
+        _map = nullptr;
+        if (_fd >= 0)
+            ::close(_fd);
+        _fd = -1;
+    }
+
+    const pattern_header *header() const { return &_hdr; }
+
+    uint64_t count() const { return _count; }
+
+    // Record i, which must be in the window: call prefetch(i) first.
+    const pattern_record &record(uint64_t i) const
+    {
+        uint64_t pos = sizeof(pattern_header) + i * sizeof(pattern_record);
+        return *(const pattern_record *)((const char *)_map + (pos - _map_off));
+    }
+
+    // Any record, read with a system call rather than through the window.
+    // For looking at the file, not for playback.
+    bool read_record(uint64_t i, pattern_record &rec) const
+    {
+        off_t pos = sizeof(pattern_header) + i * sizeof(pattern_record);
+        return i < _count && pread(_fd, &rec, sizeof(rec), pos) == ssize_t(sizeof(rec));
+    }
+
+    // Record i is about to be played. When the play position has moved a
+    // chunk, move the window: unmap what's behind (and drop it from the
+    // page cache) and map and request the next chunk ahead. Returns true
+    // if it made system calls (so the caller knows the time went
+    // somewhere).
+    bool prefetch(uint64_t i)
+    {
+        uint64_t pos = sizeof(pattern_header) + i * sizeof(pattern_record);
+        if (pos < _map_off + _chunk)
+            return false;
+
+        uint64_t old_off = _map_off;
+        uint64_t old_end = _map_off + _map_len;
+        if (!map(pos / _chunk * _chunk))
+            return true; // keep the old window; record() will fault
+
+        posix_fadvise(_fd, old_off, _map_off - old_off, POSIX_FADV_DONTNEED);
+        uint64_t new_end = _map_off + _map_len;
+        if (new_end > old_end)
+            madvise((char *)_map + (old_end - _map_off), new_end - old_end, MADV_WILLNEED);
+
+        return true;
+    }
+
+    // Whether record i is the first one on its page. Records don't start
+    // on a page boundary (the header comes first), so this isn't i modulo
+    // records per page.
+    bool first_on_page(uint64_t i) const
+    {
+        uint64_t pos = sizeof(pattern_header) + i * sizeof(pattern_record);
+        return pos % _page < sizeof(pattern_record);
+    }
+
+    // Whether the page holding record i is in memory (false means reading
+    // it will wait for the disk). Record i must be in the window.
+    bool resident(uint64_t i) const
+    {
+        uint64_t pos = sizeof(pattern_header) + i * sizeof(pattern_record);
+        uint64_t start = pos / _page * _page;
+        unsigned char vec = 0;
+        if (mincore((char *)_map + (start - _map_off), 1, &vec) != 0)
+            return true; // can't tell; don't complain
+        return (vec & 1) != 0;
+    }
+
+private:
+
+    // Map window + chunk bytes of the file starting at off (a multiple of
+    // the chunk size), replacing the current mapping.
+    bool map(uint64_t off)
+    {
+        uint64_t len = _window + _chunk;
+        if (len > _file_size - off)
+            len = _file_size - off;
+        void *p = mmap(nullptr, len, PROT_READ, MAP_SHARED, _fd, off);
+        if (p == MAP_FAILED)
+            return false;
+        madvise(p, len, MADV_SEQUENTIAL);
+        if (_map != nullptr)
+            munmap(_map, _map_len);
+        _map = p;
+        _map_off = off;
+        _map_len = len;
+        return true;
+    }
+
+    int _fd;
+    pattern_header _hdr;
+    uint64_t _file_size;
+    void *_map;
+    uint64_t _map_off;      // file offset of the mapping
+    size_t _map_len;
+    size_t _page;
+    size_t _window;
+    size_t _chunk;
+    uint64_t _count;
+
+}; // class pattern_reader
@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <stdio.h>
+#include "line_bits.h"
+#include "pattern.h"
+
+// Make a pattern file for output_stream (see pattern.h).
+//
+// Usage: pattern_gen [-n records] [-i interval_us] [-k counter|prbs|walk]
+//                    [-l chip:offset[,offset...]] file
+//
+//   -n   number of records, default 1000000 (16 bytes each, so e.g.
+//        -n 250000000 makes a 4 GB file)
+//   -i   time between records, default 1000
+//   -k   counter: binary count (output2_simple's counter)
+//        prbs: pseudo-random values (xorshift, fixed seed)
+//        walk: one line high at a time, in turn
+//   -l   lines the pattern is for, default /dev/gpiochip0:23,24
+
+static const char *default_lines = "/dev/gpiochip0:23,24";
+
+static const int max_lines = pattern_max_lines;
+
+static bool parse_lines(const char *arg, char *chip_path, size_t chip_len,
+                        unsigned int *offsets, int &num_offsets)
+{
+    const char *colon = strchr(arg, ':');
+    if (colon == nullptr || size_t(colon - arg) >= chip_len)
+        return false;
+    memcpy(chip_path, arg, colon - arg);
+    chip_path[colon - arg] = '\0';
+    num_offsets = 0;
+    const char *p = colon + 1;
+    while (*p != '\0' && num_offsets < max_lines) {
+        char *end;
+        offsets[num_offsets++] = strtoul(p, &end, 0);
+        if (end == p)
+            return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return num_offsets > 0 && *p == '\0';
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    uint64_t num_records = 1000000;
+    uint64_t interval_us = 1000;
+    const char *kind = "counter";
+    const char *lines_arg = default_lines;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_records = strtoull(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval_us = strtoull(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            kind = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            lines_arg = argv[++i];
+        } else if (argv[i][0] != '-' && path == nullptr) {
+            path = argv[i];
+        } else {
+            argc = 0; // force usage message
+        }
+    }
+
+    char chip_path[64];
+    unsigned int offsets[max_lines];
+    int num_lines = 0;
+
+    bool kind_ok = strcmp(kind, "counter") == 0 || strcmp(kind, "prbs") == 0 ||
+                   strcmp(kind, "walk") == 0;
+
+    if (argc == 0 || path == nullptr || !kind_ok || interval_us == 0 ||
+        !parse_lines(lines_arg, chip_path, sizeof(chip_path), offsets, num_lines)) {
+        fprintf(stderr, "usage: %s [-n records] [-i interval_us] [-k counter|prbs|walk]"
+                " [-l chip:offset[,offset...]] file\n", argv[0]);
+        return 1;
+    }
+
+    pattern_writer writer;
+    if (!writer.open(path)) {
+        fprintf(stderr, "%s: can't create %s: %s\n", argv[0], path, strerror(errno));
+        return 1;
+    }
+
+    pattern_header *hdr = writer.header();
+    memcpy(hdr->chip_path, chip_path, sizeof(hdr->chip_path)); // both 64, terminated
+    hdr->num_offsets = num_lines;
+    for (int i = 0; i < num_lines; i++)
+        hdr->offsets[i] = offsets[i];
+
+    const uint64_t mask = line_bits_mask(num_lines);
+    uint64_t prbs = 0x9e3779b97f4a7c15ULL;
+
+    for (uint64_t n = 0; n < num_records; n++) {
+        pattern_record rec;
+        rec.time_ns = n * interval_us * 1000;
+        if (kind[0] == 'c') {
+            rec.bits = n & mask;
+        } else if (kind[0] == 'p') {
+            prbs ^= prbs << 13;
+            prbs ^= prbs >> 7;
+            prbs ^= prbs << 17;
+            rec.bits = prbs & mask;
+        } else {
+            rec.bits = uint64_t(1) << (n % num_lines);
+        }
+        if (!writer.append(rec)) {
+            fprintf(stderr, "%s: write failed after %" PRIu64 " records: %s\n", argv[0], n,
+                    strerror(errno));
+            return 1;
+        }
+    }
+
+    if (!writer.close()) {
+        fprintf(stderr, "%s: error finishing %s: %s\n", argv[0], path, strerror(errno));
+        return 1;
+    }
+
+    printf("%s: %" PRIu64 " records, %d lines, %.3f sec\n", path, num_records, num_lines,
+           num_records * interval_us / 1e6);
+
+    return 0;
+
+} // main
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+// Quadrature (a/b encoder) decoder driven by edge events.
+//
+// The a and b inputs form a 2-bit state, a in bit 1 and b in bit 0.
+// Turning forward steps the state 00 -> 10 -> 11 -> 01 -> 00 (a leads b);
+// backward steps the other way. Each edge event gives the new value of
+// one line; the (old state, new state) pair indexes a 16-entry table
+// giving the position change (-1, 0, +1) and whether the transition is
+// illegal, so decoding an edge is a table lookup with no branches.
+//
+// Illegal transitions are those where the state did not change (an edge
+// reporting the value the line already had, meaning an opposite edge was
+// missed) or where both bits changed (only possible if events were lost).
+//
+// Velocity is estimated from the event timestamps as the position change
+// over the last velocity_window edges. Edges only say when the encoder
+// moved, not that it stopped, so the caller passes the current time: once
+// no edge has come for longer than the average interval in the window,
+// the span is taken up to now instead, and the estimate falls towards
+// zero. Everything is fixed size; nothing allocates.
+
+class quadrature_decoder
+{
+public:
+
+    static const int velocity_window = 16; // edges; power of 2
+
+    quadrature_decoder() { reset(0, 0, 0); }
+
+    // Set the starting line values (e.g. from gpiod_line_request_get_values)
+    // and zero everything.
+    void reset(unsigned a_val, unsigned b_val, uint64_t timestamp_ns)
+    {
+        _state = ((a_val & 1) << 1) | (b_val & 1);
+        position = 0;
+        forward = 0;
+        reverse = 0;
+        illegal = 0;
+        _edges = 0;
+        for (int i = 0; i < velocity_window; i++) {
+            _hist_ns[i] = timestamp_ns;
+            _hist_pos[i] = 0;
+        }
+    }
+
+    // One edge: line is 0 for a, 1 for b; value is the new line value.
+    void edge(unsigned line, unsigned value, uint64_t timestamp_ns)
+    {
+        unsigned bit = 1 - line;    // a is bit 1, b is bit 0
+        unsigned next = (_state & ~(1u << bit)) | ((value & 1) << bit);
+        const entry &t = table[(_state << 2) | next];
+        position += t.delta;
+        forward += t.delta > 0;
+        reverse += t.delta < 0;
+        illegal += t.illegal;
+        _state = next;
+
+        unsigned h = _edges++ & (velocity_window - 1);
+        _hist_ns[h] = timestamp_ns;
+        _hist_pos[h] = position;
+    }
+
+    // Counts per second over the last velocity_window edges (or fewer at
+    // startup), as of now_ns (same clock as the edge timestamps). If the
+    // next edge is overdue the span runs to now_ns, so this is an upper
+    // bound that goes to zero as the encoder stays still. Zero if there's
+    // no time span to measure over.
+    double velocity(uint64_t now_ns) const
+    {
+        if (_edges < 2)
+            return 0.0;
+        unsigned newest = (_edges - 1) & (velocity_window - 1);
+        unsigned oldest = _edges < velocity_window ? 0 : _edges & (velocity_window - 1);
+        uint64_t intervals = _edges < velocity_window ? _edges - 1 : velocity_window - 1;
+        uint64_t dt = _hist_ns[newest] - _hist_ns[oldest];
+        if (now_ns > _hist_ns[newest] + dt / intervals)
+            dt = now_ns - _hist_ns[oldest];
+        if (dt == 0)
+            return 0.0;
+        return (_hist_pos[newest] - _hist_pos[oldest]) * 1e9 / dt;
+    }
+
+    // +1 if the last edge stepped forward, -1 if backward, 0 if it was
+    // illegal or there have been no edges
+    int direction() const
+    {
+        if (_edges == 0)
+            return 0;
+        // the history starts zeroed, so this works for the first edge too
+        unsigned newest = (_edges - 1) & (velocity_window - 1);
+        unsigned prev = (_edges - 2) & (velocity_window - 1);
+        int64_t d = _hist_pos[newest] - _hist_pos[prev];
+        return (d > 0) - (d < 0);
+    }
+
+    unsigned state() const { return _state; }
+
+    int64_t position;   // net counts
+    uint64_t forward;   // forward steps
+    uint64_t reverse;   // backward steps
+    uint64_t illegal;   // illegal transitions
+
+private:
+
+    struct entry {
+        int8_t delta;
+        uint8_t illegal;
+    };
+
+    // indexed by (old state << 2) | new state
+    static constexpr entry table[16] = {
+        //           new: 00        01        10        11
+        /* old 00 */ { 0, 1 }, { -1, 0 }, { +1, 0 }, { 0, 1 },
+        /* old 01 */ { +1, 0 }, { 0, 1 }, { 0, 1 }, { -1, 0 },
+        /* old 10 */ { -1, 0 }, { 0, 1 }, { 0, 1 }, { +1, 0 },
+        /* old 11 */ { 0, 1 }, { +1, 0 }, { -1, 0 }, { 0, 1 },
+    };
+
+    unsigned _state;
+    uint64_t _edges;
+    uint64_t _hist_ns[velocity_window];
+    int64_t _hist_pos[velocity_window];
+
+}; // class quadrature_decoder
@@ -0,0 +1,183 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "histogram.h"
+#include "rt_profile.h"
+
+// Wakeup latency of a periodic loop, with and without the real-time
+// profile, under load.
+//
+// The loop sleeps to an absolute deadline every interval and records how
+// late it woke up, which is what the event and toggle loops see between
+// an interrupt (or deadline) and getting to run. It is run twice, each in
+// its own process: once with default scheduling, once with the profile
+// from rt_profile.h applied.
+//
+// Unless -n is given, both runs happen under a built-in stress load: one
+// process per CPU spinning, plus one per CPU repeatedly allocating,
+// touching, and freeing a large buffer (page faults, cache and TLB
+// pressure, and work for the memory management code).
+//
+// Usage: rt_bench [-d seconds] [-i interval_us] [-n] [-r] [-p priority] [-c cpu]
+//
+// The rt run always applies the profile; -p and -c change its priority
+// and pinning. Without root (or CAP_SYS_NICE) SCHED_FIFO fails, and the
+// rt run says so and measures whatever else it could apply.
+
+static const size_t stress_mem_bytes = 64 * 1024 * 1024;
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+static void stress_cpu()
+{
+    volatile uint64_t n = 0;
+    while (true)
+        n++;
+}
+
+
+static void stress_mem()
+{
+    while (true) {
+        char *p = (char *)malloc(stress_mem_bytes); // big enough to be an mmap
+        if (p == nullptr)
+            continue;
+        for (size_t i = 0; i < stress_mem_bytes; i += 4096)
+            p[i] = char(i);
+        free(p);
+    }
+}
+
+
+static pid_t start(void (*fn)())
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        fn();
+        _exit(0);
+    }
+    return pid;
+}
+
+
+// The measured loop; runs in a child process so the profile doesn't leak
+// into the next run.
+static void measure(const char *name, bool rt, const rt_options &opt,
+                    int seconds, int interval_us)
+{
+    static histogram<> h; // static: in bss, locked by mlockall
+
+    if (rt)
+        rt_profile_apply(opt.priority, opt.cpu);
+    else if (opt.cpu >= 0)
+        rt_profile_apply(0, opt.cpu); // same cpu, so only the profile differs
+
+    rt_usage usage = rt_usage_now();
+
+    uint64_t interval_ns = uint64_t(interval_us) * 1000;
+    uint64_t end_ns = now_ns() + uint64_t(seconds) * 1000000000;
+    uint64_t deadline_ns = now_ns() + interval_ns;
+
+    while (deadline_ns < end_ns) {
+        timespec ts;
+        ts.tv_sec = deadline_ns / 1000000000;
+        ts.tv_nsec = deadline_ns % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+            ;
+        uint64_t woke_ns = now_ns();
+        h.record(woke_ns - deadline_ns);
+        deadline_ns += interval_ns;
+        // if we fell more than an interval behind, skip to the next one
+        if (deadline_ns <= woke_ns)
+            deadline_ns = woke_ns + interval_ns;
+    }
+
+    printf("%-7s %7" PRIu64 " wakeups: usec p50 %.1f p99 %.1f p99.9 %.1f max %.1f\n", name,
+           h.count(), h.percentile(50) / 1e3, h.percentile(99) / 1e3,
+           h.percentile(99.9) / 1e3, h.max() / 1e3);
+    printf("        ");
+    rt_usage_print(usage);
+    fflush(stdout);
+}
+
+
+static void run(const char *name, bool rt, const rt_options &opt, int seconds, int interval_us)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        measure(name, rt, opt, seconds, interval_us);
+        _exit(0);
+    }
+    waitpid(pid, nullptr, 0);
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    int seconds = 10;
+    int interval_us = 1000;
+    bool stress = true;
+    rt_options opt;
+    rt_options_init(opt);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            seconds = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval_us = strtol(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            stress = false;
+        } else if (!rt_options_parse(i, argc, argv, opt)) {
+            fprintf(stderr, "usage: %s [-d seconds] [-i interval_us] [-n] %s\n", argv[0],
+                    rt_options_usage);
+            return 1;
+        }
+    }
+
+    if (seconds <= 0 || interval_us <= 0) {
+        fprintf(stderr, "%s: seconds and interval must be positive\n", argv[0]);
+        return 1;
+    }
+
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const int max_stress = 256;
+    pid_t stress_pids[max_stress];
+    int num_stress = 0;
+
+    if (stress) {
+        fflush(stdout);
+        for (long c = 0; c < num_cpus && num_stress + 2 <= max_stress; c++) {
+            stress_pids[num_stress++] = start(stress_cpu);
+            stress_pids[num_stress++] = start(stress_mem);
+        }
+    }
+
+    printf("%d sec at %d usec interval, %s\n", seconds, interval_us,
+           stress ? "under stress" : "no stress");
+
+    run("default", false, opt, seconds, interval_us);
+    run("rt", true, opt, seconds, interval_us);
+
+    for (int s = 0; s < num_stress; s++) {
+        kill(stress_pids[s], SIGKILL);
+        waitpid(stress_pids[s], nullptr, 0);
+    }
+
+    return 0;
+
+} // main
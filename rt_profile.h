@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <malloc.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+// Opt-in real-time profile for a single-threaded event or toggle loop.
+//
+// rt_profile_apply() does the usual steps, in this order:
+//
+//   1. Tell malloc never to give memory back to the kernel or to use
+//      mmap for big blocks, so memory freed and reallocated in the loop
+//      does not fault again.
+//   2. mlockall(MCL_CURRENT | MCL_FUTURE). MCL_CURRENT faults in and locks
+//      everything already mapped (code, data, heap, so buffers allocated
+//      during setup), MCL_FUTURE does the same for later mappings.
+//   3. Prefault rt_stack_prefault bytes of stack, which mlockall can't do
+//      since the stack is only mapped as it grows.
+//   4. Pin to one CPU (if cpu >= 0).
+//   5. SCHED_FIFO at 'priority' (if priority > 0).
+//
+// Call it after setup (after buffers are allocated and lines requested)
+// and just before the loop. Each step that fails (usually for lack of
+// privilege: run as root, or with CAP_SYS_NICE and a big enough
+// RLIMIT_MEMLOCK) is reported and the rest are still tried.
+//
+// rt_usage records the page fault and context switch counts so the loop
+// can report what happened while it ran; with the profile applied, page
+// faults should be near zero and involuntary context switches should only
+// come from higher-priority work.
+
+static const size_t rt_stack_prefault = 256 * 1024;
+
+// Threaded irq handlers run at SCHED_FIFO 50. Going above that means the
+// loop can delay the gpio interrupt it is waiting for, so the default is
+// just under.
+static const int rt_default_priority = 49;
+
+
+// Touch each page of the stack below the caller so later calls that go
+// that deep don't fault. noinline so the array really is below the caller.
+static void __attribute__((noinline)) rt_prefault_stack()
+{
+    volatile char stack[rt_stack_prefault];
+    for (size_t i = 0; i < sizeof(stack); i += 4096)
+        stack[i] = 0;
+}
+
+
+// Apply the profile. priority 0 leaves scheduling alone, cpu -1 leaves
+// affinity alone. Returns true if every step worked.
+static inline bool rt_profile_apply(int priority, int cpu)
+{
+    bool ok = true;
+
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        fprintf(stderr, "rt: mlockall: %s\n", strerror(errno));
+        ok = false;
+    }
+
+    rt_prefault_stack();
+
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            fprintf(stderr, "rt: pin to cpu %d: %s\n", cpu, strerror(errno));
+            ok = false;
+        }
+    }
+
+    if (priority > 0) {
+        sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+            fprintf(stderr, "rt: SCHED_FIFO %d: %s\n", priority, strerror(errno));
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+
+// Command line options shared by the programs that support the profile:
+//
+//   -r             apply the profile (rt_default_priority, no pinning)
+//   -p priority    SCHED_FIFO priority (implies -r)
+//   -c cpu         pin to cpu (implies -r)
+struct rt_options {
+    bool enabled;
+    int priority;
+    int cpu;
+};
+
+static inline void rt_options_init(rt_options &opt)
+{
+    opt.enabled = false;
+    opt.priority = rt_default_priority;
+    opt.cpu = -1;
+}
+
+// If argv[i] is one of the options above, consume it (and its argument)
+// and return true, leaving i at the last argument used.
+static inline bool rt_options_parse(int &i, int argc, char *argv[], rt_options &opt)
+{
+    if (strcmp(argv[i], "-r") == 0) {
+        opt.enabled = true;
+    } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+        opt.enabled = true;
+        opt.priority = strtol(argv[++i], nullptr, 0);
+    } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+        opt.enabled = true;
+        opt.cpu = strtol(argv[++i], nullptr, 0);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static const char *const rt_options_usage = "[-r] [-p priority] [-c cpu]";
+
+
+// Page fault and context switch counts for the process.
+struct rt_usage {
+    long minflt;    // page faults satisfied without I/O
+    long majflt;    // page faults that needed I/O
+    long nvcsw;     // voluntary context switches (blocked)
+    long nivcsw;    // involuntary context switches (preempted)
+};
+
+static inline rt_usage rt_usage_now()
+{
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    rt_usage u = { ru.ru_minflt, ru.ru_majflt, ru.ru_nvcsw, ru.ru_nivcsw };
+    return u;
+}
+
+// Print what happened since 'start'.
+static inline void rt_usage_print(const rt_usage &start)
+{
+    rt_usage now = rt_usage_now();
+    printf("page faults: %ld minor, %ld major; context switches: %ld voluntary, %ld involuntary\n",
+           now.minflt - start.minflt, now.majflt - start.majflt,
+           now.nvcsw - start.nvcsw, now.nivcsw - start.nivcsw);
+}
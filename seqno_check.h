@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+// Detect lost edge events from sequence number gaps.
+//
+// The kernel numbers every edge it detects on a request (global seqno)
+// and on each line (line seqno), starting at 1, before putting the event
+// in its buffer. If the buffer is full the kernel discards the oldest
+// event still queued to make room and keeps the new one, so what goes
+// missing is older events the reader hadn't got to yet, never the latest.
+// A jump in either seqno means events were lost. The global seqno says how
+// many; the line seqnos say on which lines. The gap shows up in front of
+// the oldest event that survived.
+//
+// Lines are identified by index (0 .. num_lines-1), not offset.
+
+template <int num_lines>
+class seqno_check
+{
+public:
+
+    seqno_check() : global_missed(0), _last_global(0), _seen_global(false)
+    {
+        for (int i = 0; i < num_lines; i++) {
+            _last_line[i] = 0;
+            _seen_line[i] = false;
+            line_missed[i] = 0;
+        }
+    }
+
+    // Check one event's seqnos. Returns the number of events missed
+    // (request-wide) just before this one; zero normally.
+    //
+    // The kernel's seqnos are 32 bits (libgpiod hands them out as unsigned
+    // long), so the arithmetic is done in 32 bits and a wrap from
+    // 0xffffffff to 0 is just the next number.
+    uint64_t check(unsigned long global_seqno, int line, unsigned long line_seqno)
+    {
+        uint32_t global = uint32_t(global_seqno);
+        uint32_t missed = 0;
+        if (_seen_global)
+            missed = global - _last_global - 1;
+        _last_global = global;
+        _seen_global = true;
+        global_missed += missed;
+
+        uint32_t line32 = uint32_t(line_seqno);
+        if (_seen_line[line])
+            line_missed[line] += uint32_t(line32 - _last_line[line] - 1);
+        _last_line[line] = line32;
+        _seen_line[line] = true;
+
+        return missed;
+    }
+
+    uint64_t global_missed;             // total events lost
+    uint64_t line_missed[num_lines];    // events lost, per line
+
+private:
+
+    uint32_t _last_global;
+    bool _seen_global;
+    uint32_t _last_line[num_lines];
+    bool _seen_line[num_lines];
+
+}; // class seqno_check
@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <cstring>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h> // ctrl-c handler
+#include <stdio.h>
+#include <unistd.h>
+#include "shm_ring.h"
+
+// Read edge events published by input_events_publish and print them the
+// way input_events does. Several of these can run at once; each sees
+// every event (subject to the publisher's slow-consumer policy).
+//
+// Usage: shm_consumer [socket]    (default /tmp/gpio_events.sock)
+
+static const char *default_socket = "/tmp/gpio_events.sock";
+
+static volatile sig_atomic_t quitting = false;
+
+static void ctrl_c_handler(int notused)
+{
+    quitting = true;
+}
+
+
+int main(int argc, char *argv[])
+{
+
+    const char *socket_path = argc > 1 ? argv[1] : default_socket;
+
+    int fd = shm_ring_connect(socket_path);
+    if (fd < 0) {
+        fprintf(stderr, "%s: can't connect to %s: %s\n", argv[0], socket_path, strerror(errno));
+        return 1;
+    }
+
+    shm_ring_reader ring;
+    if (!ring.attach(fd)) {
+        fprintf(stderr, "%s: can't attach to ring: %s\n", argv[0], strerror(errno));
+        return 1;
+    }
+    close(fd); // the mapping keeps the memory
+
+    uint64_t last_ns = 0;
+    uint64_t last_lost = 0;
+
+    // ctrl-c sets 'quitting' flag
+    signal(SIGINT, ctrl_c_handler);
+
+    while (!quitting) {
+
+        const edge_record *rec = ring.peek();
+
+        if (rec == nullptr) {
+            // Nothing to read: sleep until the publisher says otherwise.
+            // The timeout is just so ctrl-c is noticed.
+            fflush(stdout);
+            ring.wait(100);
+            continue;
+        }
+
+        // Format straight out of the shared ring, then check that the
+        // record wasn't overwritten while we did.
+        char line[128];
+        int n = snprintf(line, sizeof(line), "%" PRIu32 ":%" PRIu32 " pin %" PRIu32
+                         " = %" PRIu32 " @ %" PRIu64, rec->global_seqno, rec->line_seqno,
+                         rec->offset, rec->rising, rec->timestamp_ns);
+        if (last_ns != 0)
+            snprintf(line + n, sizeof(line) - n, " +%" PRIu64, rec->timestamp_ns - last_ns);
+        uint64_t timestamp_ns = rec->timestamp_ns;
+
+        if (!ring.advance())
+            continue;
+
+        last_ns = timestamp_ns;
+        printf("%s\n", line);
+
+        uint64_t lost = ring.lost();
+        if (lost != last_lost) {
+            printf("lost %" PRIu64 " events\n", lost - last_lost);
+            last_lost = lost;
+        }
+
+    } // while
+
+    printf("%" PRIu64 " events lost\n", ring.lost());
+
+    ring.detach();
+
+    return 0;
+
+} // main
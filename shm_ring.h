@@ -0,0 +1,457 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "edge_record.h"
+
+// Edge events shared with other processes through a memfd.
+//
+// One publisher (the process holding the lines) writes edge_records into
+// a ring in shared memory; any number of consumer processes (up to
+// shm_ring_max_consumers) map the same memory and each reads at its own
+// cursor. Consumers read records in place (no copy) and only make a
+// system call when the ring is empty and they choose to sleep
+// (shm_ring_reader::wait); the publisher only makes one (a futex wake)
+// when some consumer is actually sleeping.
+//
+// What happens when a consumer falls a whole ring behind is set by the
+// publisher's policy:
+//
+//   drop       New events are not written until the slowest consumer
+//              catches up. All consumers miss them; they are counted in
+//              the header. The publisher never waits.
+//   overwrite  The publisher always writes. A consumer that was lapped
+//              skips ahead to the oldest record still there and counts
+//              what it missed. Fast consumers are unaffected.
+//   block      The publisher waits for the slowest consumer. Nothing is
+//              lost in the ring, but while it waits the kernel's event
+//              buffer is filling. Consumers that exit without detaching
+//              are noticed (by pid) and stop blocking it.
+//
+// Each slot has a sequence number (position + 1 when valid, 0 while being
+// written) so a consumer can tell whether a record it is looking at was
+// overwritten underneath it.
+//
+// The memfd is passed to consumers over a Unix socket with SCM_RIGHTS:
+// see shm_ring_serve() and shm_ring_connect().
+
+static const uint32_t shm_ring_magic = 0x52455047; // "GPER"
+static const uint32_t shm_ring_version = 1;
+static const int shm_ring_max_consumers = 16;
+static const int shm_ring_reap_interval = 256; // drop policy: drops between reaps
+
+enum shm_ring_policy : uint32_t {
+    shm_ring_drop,
+    shm_ring_overwrite,
+    shm_ring_block,
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory needs lock-free 64-bit atomics");
+
+struct shm_ring_slot {
+    std::atomic<uint64_t> seq;      // position + 1 when valid, 0 while writing
+    edge_record rec;
+};
+
+struct alignas(64) shm_ring_consumer_state {
+    std::atomic<uint32_t> active;
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> cursor;   // next position this consumer reads
+    std::atomic<uint64_t> lost;     // records skipped (overwrite policy)
+};
+
+struct shm_ring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;              // slots, power of 2
+    uint32_t policy;                // shm_ring_policy
+    alignas(64) std::atomic<uint64_t> head;     // next position to write
+    std::atomic<uint64_t> dropped;              // drop policy: not written
+    alignas(64) std::atomic<uint32_t> futex_seq;// bumped on each publish
+    std::atomic<uint32_t> waiters;              // consumers in futex wait
+    shm_ring_consumer_state consumers[shm_ring_max_consumers];
+};
+
+static inline size_t shm_ring_size(uint32_t capacity)
+{
+    return sizeof(shm_ring_header) + capacity * sizeof(shm_ring_slot);
+}
+
+static inline shm_ring_slot *shm_ring_slots(shm_ring_header *hdr)
+{
+    return (shm_ring_slot *)(hdr + 1);
+}
+
+
+class shm_ring_publisher
+{
+public:
+
+    shm_ring_publisher() : _fd(-1), _hdr(nullptr), _drops_since_reap(0) { }
+
+    ~shm_ring_publisher()
+    {
+        if (_hdr != nullptr)
+            munmap(_hdr, shm_ring_size(_hdr->capacity));
+        if (_fd >= 0)
+            close(_fd);
+    }
+
+    // capacity must be a power of two
+    bool create(uint32_t capacity, shm_ring_policy policy)
+    {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        _fd = memfd_create("gpio_events", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (_fd < 0)
+            return false;
+        size_t size = shm_ring_size(capacity);
+        if (ftruncate(_fd, size) != 0)
+            return false;
+        // consumers can't resize it out from under us
+        fcntl(_fd, F_ADD_SEALS, F_SEAL_GROW | F_SEAL_SHRINK | F_SEAL_SEAL);
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, 0);
+        if (p == MAP_FAILED)
+            return false;
+        // fresh memfd pages are zero, which is a valid initial state for
+        // all the atomics
+        _hdr = (shm_ring_header *)p;
+        _hdr->capacity = capacity;
+        _hdr->policy = policy;
+        _hdr->version = shm_ring_version;
+        std::atomic_thread_fence(std::memory_order_release);
+        _hdr->magic = shm_ring_magic;
+        return true;
+    }
+
+    int fd() const { return _fd; }
+
+    // Write one record. Returns false if it was dropped (drop policy), or
+    // if *stop became nonzero while waiting for space (block policy).
+    // Call notify() after a batch.
+    bool publish(const edge_record &rec, const volatile sig_atomic_t *stop = nullptr)
+    {
+        uint64_t pos = _hdr->head.load(std::memory_order_relaxed);
+
+        if (_hdr->policy != shm_ring_overwrite) {
+            bool reaped = false;
+            while (pos - min_cursor(pos) >= _hdr->capacity) {
+                if (_hdr->policy == shm_ring_drop) {
+                    // A consumer that died would pin its cursor and make
+                    // every later event drop, so look for dead ones on the
+                    // first drop of a run and every so often after that,
+                    // then check again.
+                    if (!reaped && _drops_since_reap++ % shm_ring_reap_interval == 0) {
+                        reap();
+                        reaped = true;
+                        continue;
+                    }
+                    _hdr->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                // block: make sure sleeping consumers are awake to free
+                // space, give them a moment, and drop dead ones
+                if (stop != nullptr && *stop)
+                    return false;
+                notify();
+                struct timespec ts = { 0, 50000 };
+                nanosleep(&ts, nullptr);
+                reap();
+            }
+        }
+
+        shm_ring_slot &slot = shm_ring_slots(_hdr)[pos & (_hdr->capacity - 1)];
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.rec = rec;
+        slot.seq.store(pos + 1, std::memory_order_release);
+        _hdr->head.store(pos + 1, std::memory_order_release);
+        _drops_since_reap = 0;
+        return true;
+    }
+
+    // Wake consumers sleeping in wait(). No syscall if none are.
+    void notify()
+    {
+        _hdr->futex_seq.fetch_add(1);
+        if (_hdr->waiters.load() != 0)
+            syscall(SYS_futex, &_hdr->futex_seq, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    uint64_t dropped() const { return _hdr->dropped.load(std::memory_order_relaxed); }
+
+    int consumers() const
+    {
+        int n = 0;
+        for (int i = 0; i < shm_ring_max_consumers; i++)
+            n += _hdr->consumers[i].active.load(std::memory_order_relaxed) == 1;
+        return n;
+    }
+
+private:
+
+    // Oldest cursor of any active consumer, or pos if there are none.
+    // Slots still being set up (active 2) don't have a valid cursor yet.
+    uint64_t min_cursor(uint64_t pos) const
+    {
+        uint64_t min = pos;
+        for (int i = 0; i < shm_ring_max_consumers; i++) {
+            const shm_ring_consumer_state &c = _hdr->consumers[i];
+            if (c.active.load(std::memory_order_acquire) != 1)
+                continue;
+            uint64_t cursor = c.cursor.load(std::memory_order_acquire);
+            if (cursor < min)
+                min = cursor;
+        }
+        return min;
+    }
+
+    // Deactivate consumers whose process is gone. Slots being set up are
+    // left alone; their pid may not be written yet.
+    void reap()
+    {
+        for (int i = 0; i < shm_ring_max_consumers; i++) {
+            shm_ring_consumer_state &c = _hdr->consumers[i];
+            if (c.active.load() != 1)
+                continue;
+            uint32_t expected = 1;
+            if (kill(c.pid.load(), 0) != 0 && errno == ESRCH)
+                c.active.compare_exchange_strong(expected, 0);
+        }
+    }
+
+    int _fd;
+    shm_ring_header *_hdr;
+    uint64_t _drops_since_reap;     // drop policy: consecutive drops
+
+}; // class shm_ring_publisher
+
+
+class shm_ring_reader
+{
+public:
+
+    shm_ring_reader() : _hdr(nullptr), _me(nullptr) { }
+
+    ~shm_ring_reader() { detach(); }
+
+    // Map the ring from fd and take a consumer slot. Reading starts with
+    // the next record published. fd can be closed afterwards.
+    bool attach(int fd)
+    {
+        uint32_t probe[3]; // magic, version, capacity
+        if (pread(fd, probe, sizeof(probe), 0) != sizeof(probe))
+            return false;
+        if (probe[0] != shm_ring_magic || probe[1] != shm_ring_version)
+            return false;
+        _size = shm_ring_size(probe[2]);
+        void *p = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+            return false;
+        _hdr = (shm_ring_header *)p;
+        _slots = shm_ring_slots(_hdr);
+        _mask = _hdr->capacity - 1;
+
+        for (int i = 0; i < shm_ring_max_consumers; i++) {
+            shm_ring_consumer_state &c = _hdr->consumers[i];
+            uint32_t expected = 0;
+            // claim it with active = 2 (setting up) so the publisher
+            // ignores it until the cursor is valid
+            if (c.active.compare_exchange_strong(expected, 2)) {
+                c.pid.store(getpid());
+                c.lost.store(0);
+                _cursor = _hdr->head.load(std::memory_order_acquire);
+                c.cursor.store(_cursor, std::memory_order_release);
+                c.active.store(1, std::memory_order_release);
+                _me = &c;
+                return true;
+            }
+        }
+
+        munmap(_hdr, _size);
+        _hdr = nullptr;
+        errno = EBUSY;
+        return false;
+    }
+
+    void detach()
+    {
+        if (_me != nullptr)
+            _me->active.store(0, std::memory_order_release);
+        _me = nullptr;
+        if (_hdr != nullptr)
+            munmap(_hdr, _size);
+        _hdr = nullptr;
+    }
+
+    // Next record, or nullptr if there isn't one yet. The pointer is into
+    // the shared ring; call advance() when done with it.
+    const edge_record *peek()
+    {
+        while (true) {
+            uint64_t head = _hdr->head.load(std::memory_order_acquire);
+            if (_cursor == head)
+                return nullptr;
+            if (head - _cursor > _hdr->capacity) {
+                // lapped (overwrite policy): skip to the oldest record
+                uint64_t skip = head - _hdr->capacity - _cursor;
+                _me->lost.fetch_add(skip, std::memory_order_relaxed);
+                _cursor += skip;
+            }
+            uint64_t seq = _slots[_cursor & _mask].seq.load(std::memory_order_acquire);
+            if (seq == _cursor + 1)
+                return &_slots[_cursor & _mask].rec;
+            // being overwritten right now; go around again
+            _me->lost.fetch_add(1, std::memory_order_relaxed);
+            _cursor++;
+            _me->cursor.store(_cursor, std::memory_order_release);
+        }
+    }
+
+    // Done with the record from peek(). Returns false if it was
+    // overwritten while it was being used (overwrite policy only), in
+    // which case whatever was read from it should be discarded.
+    bool advance()
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool ok = _slots[_cursor & _mask].seq.load(std::memory_order_relaxed) == _cursor + 1;
+        if (!ok)
+            _me->lost.fetch_add(1, std::memory_order_relaxed);
+        _cursor++;
+        _me->cursor.store(_cursor, std::memory_order_release);
+        return ok;
+    }
+
+    // Sleep until something is published or timeout_ms passes (-1 for
+    // forever). Returns true if there may be records to read.
+    bool wait(int timeout_ms)
+    {
+        _hdr->waiters.fetch_add(1);
+        uint32_t seen = _hdr->futex_seq.load();
+        bool ready = _cursor != _hdr->head.load();
+        if (!ready) {
+            struct timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+            syscall(SYS_futex, &_hdr->futex_seq, FUTEX_WAIT, seen,
+                    timeout_ms < 0 ? nullptr : &ts, nullptr, 0);
+        }
+        _hdr->waiters.fetch_sub(1);
+        return _cursor != _hdr->head.load(std::memory_order_acquire);
+    }
+
+    // Records this consumer has missed: those it was lapped on plus any
+    // the publisher dropped.
+    uint64_t lost() const
+    {
+        return _me->lost.load(std::memory_order_relaxed) +
+               _hdr->dropped.load(std::memory_order_relaxed);
+    }
+
+    // Records published but not read yet.
+    uint64_t backlog() const
+    {
+        return _hdr->head.load(std::memory_order_acquire) - _cursor;
+    }
+
+    shm_ring_policy policy() const { return shm_ring_policy(_hdr->policy); }
+
+private:
+
+    shm_ring_header *_hdr;
+    shm_ring_slot *_slots;
+    shm_ring_consumer_state *_me;
+    size_t _size;
+    uint64_t _mask;
+    uint64_t _cursor;
+
+}; // class shm_ring_reader
+
+
+// Send memfd to one client connected on listen_sock (call when it is
+// readable). Returns false on error.
+static inline bool shm_ring_serve(int listen_sock, int memfd)
+{
+    int conn = accept4(listen_sock, nullptr, nullptr, SOCK_CLOEXEC);
+    if (conn < 0)
+        return false;
+
+    char ok = 0;
+    iovec iov = { &ok, 1 };
+    union {
+        cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &memfd, sizeof(memfd));
+
+    bool sent = sendmsg(conn, &msg, MSG_NOSIGNAL) == 1;
+    close(conn);
+    return sent;
+}
+
+
+// Connect to a publisher and get its memfd, or -1 (errno set).
+static inline int shm_ring_connect(const char *socket_path)
+{
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+        return -1;
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    if (connect(sock, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        int e = errno;
+        close(sock);
+        errno = e;
+        return -1;
+    }
+
+    char ok;
+    iovec iov = { &ok, 1 };
+    union {
+        cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    close(sock);
+    cmsghdr *cmsg = n == 1 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        errno = EPROTO;
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+    return fd;
+}
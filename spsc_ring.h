@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Single-producer, single-consumer lock-free ring of T.
+//
+// Storage is part of the object (no heap), so declare one static or as a
+// global and it is ready before the first event arrives. push() and pop()
+// never block and never allocate; push() returns false when the ring is
+// full and the caller decides what to do (usually count a drop).
+//
+// head and tail are free-running counters; the slot index is the counter
+// masked by (capacity - 1), which is why capacity must be a power of two.
+
+template <typename T, size_t capacity>
+class spsc_ring
+{
+    static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+                  "spsc_ring capacity must be a power of two");
+
+public:
+
+    spsc_ring() : _head(0), _tail(0), _head_cache(0), _tail_cache(0) { }
+
+    // producer side
+    bool push(const T &item)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail_cache == capacity) {
+            // looks full; refresh our copy of the consumer's index
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if (head - _tail_cache == capacity)
+                return false;
+        }
+        _items[head & (capacity - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool pop(T &item)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head_cache) {
+            // looks empty; refresh our copy of the producer's index
+            _head_cache = _head.load(std::memory_order_acquire);
+            if (tail == _head_cache)
+                return false;
+        }
+        item = _items[tail & (capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of items in the ring. Exact when called from either end,
+    // a snapshot otherwise.
+    size_t size() const
+    {
+        size_t tail = _tail.load(std::memory_order_acquire);
+        size_t head = _head.load(std::memory_order_acquire);
+        return head - tail;
+    }
+
+    static constexpr size_t get_capacity() { return capacity; }
+
+private:
+
+    // Producer and consumer indexes are on separate cache lines so the
+    // two threads don't bounce one line back and forth. Each side also
+    // keeps a cached copy of the other side's index so it only touches
+    // the other line when the ring looks full (or empty).
+    alignas(64) std::atomic<size_t> _head;  // written by producer
+    alignas(64) std::atomic<size_t> _tail;  // written by consumer
+    alignas(64) size_t _head_cache;         // consumer's copy of _head
+    alignas(64) size_t _tail_cache;         // producer's copy of _tail
+    alignas(64) T _items[capacity];
+
+}; // class spsc_ring
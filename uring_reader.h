@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <errno.h>
+#include <linux/gpio.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Read edge events from line request fds with io_uring.
+//
+// A read is kept queued on each fd at all times. When a read completes
+// the raw struct gpio_v2_line_event records it returned are handed to the
+// fd's handler, and another read is queued. Queuing the new reads and
+// waiting for the next completion is a single io_uring_enter call, so the
+// steady state is one syscall per wakeup instead of the poll plus read
+// that gpiod_line_request_wait_edge_events/read_edge_events cost.
+//
+// This talks to the kernel directly (io_uring_setup, io_uring_enter and
+// the shared rings) rather than needing liburing. Kernel 5.6 or later is
+// needed for IORING_OP_READ.
+
+class uring_reader
+{
+public:
+
+    typedef void (*handler_fn)(const gpio_v2_line_event *events, int num_events, void *arg);
+
+    static const int max_fds = 16;
+    static const int max_events = 32; // per read
+
+    uring_reader() : _ring_fd(-1), _num_slots(0), _to_submit(0), _syscalls(0) { }
+
+    ~uring_reader()
+    {
+        if (_ring_fd < 0)
+            return;
+        munmap(_sqes, _sqes_size);
+        if (_cq_ptr != _sq_ptr)
+            munmap(_cq_ptr, _cq_size);
+        munmap(_sq_ptr, _sq_size);
+        close(_ring_fd);
+    }
+
+    // Create the rings. Returns false (errno set) if io_uring is not
+    // available.
+    bool init()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        _ring_fd = syscall(__NR_io_uring_setup, max_fds, &params);
+        if (_ring_fd < 0)
+            return false;
+
+        _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap && _cq_size > _sq_size)
+            _sq_size = _cq_size;
+
+        _sq_ptr = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+        assert(_sq_ptr != MAP_FAILED);
+        if (single_mmap) {
+            _cq_ptr = _sq_ptr;
+        } else {
+            _cq_ptr = mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+            assert(_cq_ptr != MAP_FAILED);
+        }
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = (io_uring_sqe *)mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+        assert(_sqes != MAP_FAILED);
+
+        char *sq = (char *)_sq_ptr;
+        _sq_head = (unsigned *)(sq + params.sq_off.head);
+        _sq_tail = (unsigned *)(sq + params.sq_off.tail);
+        _sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+        _sq_entries = params.sq_entries;
+        _sq_array = (unsigned *)(sq + params.sq_off.array);
+
+        char *cq = (char *)_cq_ptr;
+        _cq_head = (unsigned *)(cq + params.cq_off.head);
+        _cq_tail = (unsigned *)(cq + params.cq_off.tail);
+        _cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+        _cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+        return true;
+    }
+
+    // Start reading fd (e.g. from gpiod_line_request_get_fd). The first
+    // read is queued and submitted by the next wait().
+    bool add(int fd, handler_fn handler, void *arg)
+    {
+        if (_num_slots >= max_fds)
+            return false;
+        slot &s = _slots[_num_slots];
+        s.fd = fd;
+        s.handler = handler;
+        s.arg = arg;
+        queue_read(_num_slots);
+        _num_slots++;
+        return true;
+    }
+
+    // Submit queued reads and wait for at least one to complete, then
+    // dispatch all completions and queue replacement reads. Returns the
+    // number of events dispatched or -1 (errno set).
+    int wait()
+    {
+        int r = syscall(__NR_io_uring_enter, _ring_fd, _to_submit, 1,
+                        IORING_ENTER_GETEVENTS, nullptr, 0);
+        _syscalls++;
+        if (r < 0)
+            return -1;
+        _to_submit -= r;
+
+        int handled = 0;
+        unsigned head = *_cq_head;
+        unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe *cqe = &_cqes[head & _cq_mask];
+            unsigned i = cqe->user_data;
+            int res = cqe->res;
+            head++;
+            assert(i < unsigned(_num_slots));
+            slot &s = _slots[i];
+            if (res < 0) {
+                // release the entry before bailing out
+                __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+                errno = -res;
+                return -1;
+            }
+            int n = res / sizeof(gpio_v2_line_event);
+            s.handler(s.events, n, s.arg);
+            handled += n;
+            queue_read(i);
+        }
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+        return handled;
+    }
+
+    // io_uring_enter calls made so far
+    uint64_t syscalls() const { return _syscalls; }
+
+private:
+
+    struct slot {
+        int fd;
+        handler_fn handler;
+        void *arg;
+        gpio_v2_line_event events[max_events];
+    };
+
+    // Put a read for slot i in the submission ring. It goes to the kernel
+    // with the next io_uring_enter.
+    void queue_read(unsigned i)
+    {
+        unsigned tail = *_sq_tail;
+        unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        // one read per slot is outstanding at most, so this can't fill
+        assert(tail - head < _sq_entries);
+        unsigned index = tail & _sq_mask;
+        io_uring_sqe *sqe = &_sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = _slots[i].fd;
+        sqe->addr = (uintptr_t)_slots[i].events;
+        sqe->len = sizeof(_slots[i].events);
+        sqe->off = -1; // read at current position (not seekable anyway)
+        sqe->user_data = i;
+        _sq_array[index] = index;
+        __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+        _to_submit++;
+    }
+
+    int _ring_fd;
+
+    void *_sq_ptr;
+    size_t _sq_size;
+    void *_cq_ptr;
+    size_t _cq_size;
+    io_uring_sqe *_sqes;
+    size_t _sqes_size;
+
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned _sq_mask;
+    unsigned _sq_entries;
+    unsigned *_sq_array;
+
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    io_uring_cqe *_cqes;
+
+    slot _slots[max_fds];
+    int _num_slots;
+    unsigned _to_submit;
+    uint64_t _syscalls;
+
+}; // class uring_reader